@@ -0,0 +1,284 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _LIGHT_CANVAS_H
+#define _LIGHT_CANVAS_H
+
+#include "LightLCD.h"
+
+/* Several panels tiled into one display of up to 256 x 256 pixels, any mix
+ * of drivers. Each panel is placed at the canvas coordinates of its top-left
+ * corner:
+ *
+ *  LightSSD1306 left(0x3C), right(0x3D);
+ *  LightCanvas<2> canvas;
+ *
+ *  canvas.addPanel(left, 0, 0);
+ *  canvas.addPanel(right, 128, 0);
+ *  canvas.begin();
+ *
+ * The primitives below are handed to every panel, with its origin and clip
+ * set to its part of the canvas for the call, so they draw straight into
+ * the panels' framebuffers. The panels keep their own settings otherwise.
+ * Through a LightLCD pointer or reference (and for text) they end up in
+ * putPixel(), which finds the panel(s) under each pixel.
+ *
+ * Each panel keeps its own dirty pages: update() only sends the panels that
+ * changed. With setInterleave() their transfers take turns, which helps
+ * when they are on different buses with DMA (LightDMASPIBus).
+ *
+ * Widths and heights given to the primitives are still 8 bits: a rectangle
+ * spans 255 pixels at most.
+ *
+ * Sprites, charts, scrolling and shadow buffers belong to the panels: use
+ * them on a panel, not on the canvas. Panels must keep the whole frame in
+ * RAM (not page-strip mode).
+ */
+template <uint8_t N>
+class LightCanvas : public LightLCD {
+    public:
+        LightCanvas() : panels(0), canvas_w(0), canvas_h(0), interleave(0) {}
+
+        // Place lcd with its top-left corner at x,y of the canvas
+        void addPanel(LightLCD &lcd, uint8_t x, uint8_t y) {
+            if (panels == N)
+                return;
+
+            Tile &t = tiles[panels++];
+
+            t.lcd = &lcd;
+            t.x   = x;
+            t.y   = y;
+            t.w   = lcd.width();
+            t.h   = lcd.height();
+
+            if (x + t.w > canvas_w) canvas_w = x + t.w;
+            if (y + t.h > canvas_h) canvas_h = y + t.h;
+
+            resetClip();
+        }
+
+        void begin() {
+            for (uint8_t i = 0; i < panels; i++)
+                tiles[i].lcd->begin();
+        }
+
+        void clear() {
+            for (uint8_t i = 0; i < panels; i++)
+                tiles[i].lcd->clear();
+
+            cursor_y = cursor_x = 0;
+        }
+
+        /* Bytes each panel sends before the next one's turn, 0 (the default)
+         * to send each panel whole, one after the other.
+         */
+        void setInterleave(uint16_t bytes) { interleave = bytes; }
+
+        void update() {
+            if (interleave == 0) {
+                for (uint8_t i = 0; i < panels; i++)
+                    tiles[i].lcd->update();
+
+                return;
+            }
+
+            beginUpdate();
+            while (!pollUpdate(interleave));
+        }
+
+        void beginUpdate() {
+            for (uint8_t i = 0; i < panels; i++)
+                tiles[i].lcd->beginUpdate();
+        }
+
+        // maxBytes for each panel, true once all of them are done
+        bool pollUpdate(uint16_t maxBytes) {
+            bool done = true;
+
+            for (uint8_t i = 0; i < panels; i++)
+                if (!tiles[i].lcd->pollUpdate(maxBytes))
+                    done = false;
+
+            return done;
+        }
+
+        void putPixel(uint8_t x, uint8_t y, uint8_t color) {
+            for (uint8_t i = 0; i < panels; i++) {
+                Tile &t = tiles[i];
+
+                if (x >= t.x && x - t.x < t.w && y >= t.y && y - t.y < t.h) {
+                    uint8_t op = t.lcd->raster_op;
+
+                    t.lcd->raster_op = raster_op;
+                    t.lcd->putPixel(x - t.x, y - t.y, color);
+                    t.lcd->raster_op = op;
+                }
+            }
+        }
+
+        void drawPixel(int16_t x, int16_t y, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawPixel(x, y, color); });
+        }
+
+        void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawLine(x0, y0, x1, y1, color); });
+        }
+
+        void drawPolyline(const int16_t *points, uint8_t count, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawPolyline(points, count, color); });
+        }
+
+        void drawPolyline(int16_t x, uint8_t step, const uint8_t *ys, uint8_t count, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawPolyline(x, step, ys, count, color); });
+        }
+
+        void drawVLine(int16_t x, int16_t y, uint8_t h, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawVLine(x, y, h, color); });
+        }
+
+        void drawHLine(int16_t x, int16_t y, uint8_t w, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawHLine(x, y, w, color); });
+        }
+
+        void drawRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawRect(x, y, w, h, color); });
+        }
+
+        void fillRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.fillRect(x, y, w, h, color); });
+        }
+
+        void drawCircle(int16_t x0, int16_t y0, uint8_t r, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawCircle(x0, y0, r, color); });
+        }
+
+        void fillCircle(int16_t x0, int16_t y0, uint8_t r, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.fillCircle(x0, y0, r, color); });
+        }
+
+        void drawRoundRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawRoundRect(x, y, w, h, r, color); });
+        }
+
+        void fillRoundRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.fillRoundRect(x, y, w, h, r, color); });
+        }
+
+        void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.drawTriangle(x0, y0, x1, y1, x2, y2, color); });
+        }
+
+        void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color) {
+            route([&](LightLCD &lcd) { lcd.fillTriangle(x0, y0, x1, y1, x2, y2, color); });
+        }
+
+        uint8_t drawChar(int16_t x, int16_t y, uint8_t c, uint8_t color = 1, uint8_t transparentBg = 1, uint8_t size = 1) {
+            uint8_t len = 0;
+
+            route([&](LightLCD &lcd) { len = lcd.drawChar(x, y, c, color, transparentBg, size); });
+
+            return len;
+        }
+
+        void drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg=1) {
+            route([&](LightLCD &lcd) { lcd.drawXBitmap(x, y, bitmap, w, h, color, transparentBg); });
+        }
+
+        void drawPageBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg=1) {
+            route([&](LightLCD &lcd) { lcd.drawPageBitmap(x, y, bitmap, w, h, color, transparentBg); });
+        }
+
+        void drawPageBitmap(int16_t x, int16_t y, const uint8_t *bitmap, const uint8_t *mask, uint8_t w, uint8_t h) {
+            route([&](LightLCD &lcd) { lcd.drawPageBitmap(x, y, bitmap, mask, w, h); });
+        }
+
+        void drawRLEBitmap(int16_t x, int16_t y, const uint8_t *data, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg=1) {
+            route([&](LightLCD &lcd) { lcd.drawRLEBitmap(x, y, data, w, h, color, transparentBg); });
+        }
+
+        // As LightLCD::write(), with the chars drawn by the panels. Checks the
+        // width before moving the cursor, which can't go past 255
+        size_t write(uint8_t c) {
+            if (c == '\n') {
+                newLine();
+            } else if (c != '\r') {
+                uint8_t c_width = drawChar(cursor_x, cursor_y, c, text_prop.color, text_prop.transparent, text_prop.size);
+
+                if (cursor_x + c_width >= width())
+                    newLine();
+                else
+                    cursor_x += c_width;
+            }
+
+            return 1;
+        }
+
+        int width()  { return canvas_w; }
+        int height() { return canvas_h; }
+
+    protected:
+        struct Tile {
+            LightLCD *lcd;
+            uint8_t   x, y;
+            uint8_t   w, h;
+        };
+
+        Tile     tiles[N];
+        uint8_t  panels;
+        uint16_t canvas_w, canvas_h;
+        uint16_t interleave;
+
+        // Draw on each panel, with the canvas' origin, clip and raster op
+        // moved to its coordinates. The panel's own are put back after.
+        template <class Draw>
+        void route(Draw draw) {
+            for (uint8_t i = 0; i < panels; i++) {
+                Tile     &t   = tiles[i];
+                LightLCD &lcd = *t.lcd;
+
+                int16_t ox  = lcd.origin_x, oy  = lcd.origin_y;
+                uint8_t cx0 = lcd.clip_x0,  cy0 = lcd.clip_y0;
+                uint8_t cx1 = lcd.clip_x1,  cy1 = lcd.clip_y1;
+                uint8_t op  = lcd.raster_op;
+
+                // The canvas clip rectangle, on this panel
+                int16_t x0 = clip_x0 > t.x ? clip_x0 - t.x : 0;
+                int16_t y0 = clip_y0 > t.y ? clip_y0 - t.y : 0;
+                int16_t x1 = clip_x1 - t.x < t.w - 1 ? clip_x1 - t.x : t.w - 1;
+                int16_t y1 = clip_y1 - t.y < t.h - 1 ? clip_y1 - t.y : t.h - 1;
+
+                if (x0 > x1 || y0 > y1) {
+                    x0 = 1;
+                    x1 = 0;
+                }
+
+                lcd.origin_x  = origin_x - t.x;
+                lcd.origin_y  = origin_y - t.y;
+                lcd.clip_x0   = x0;
+                lcd.clip_y0   = y0;
+                lcd.clip_x1   = x1;
+                lcd.clip_y1   = y1;
+                lcd.raster_op = raster_op;
+
+                draw(lcd);
+
+                lcd.origin_x  = ox;
+                lcd.origin_y  = oy;
+                lcd.clip_x0   = cx0;
+                lcd.clip_y0   = cy0;
+                lcd.clip_x1   = cx1;
+                lcd.clip_y1   = cy1;
+                lcd.raster_op = op;
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,147 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _LIGHT_I2C_BUS_H
+#define _LIGHT_I2C_BUS_H
+
+#include "LightLCDBus.h"
+#include <Wire.h>
+
+/* Bytes Wire can hold in a single transmission. Detected from the core's
+ * Wire.h, define it before including this file to override.
+ */
+#ifndef SSD1306_WIRE_BUFFER
+    #if defined(I2C_BUFFER_LENGTH)         // ESP32
+        #define SSD1306_WIRE_BUFFER I2C_BUFFER_LENGTH
+    #elif defined(WIRE_BUFFER_SIZE)        // RP2040
+        #define SSD1306_WIRE_BUFFER WIRE_BUFFER_SIZE
+    #elif defined(BUFFER_LENGTH)           // AVR, megaAVR, ESP8266
+        #define SSD1306_WIRE_BUFFER BUFFER_LENGTH
+    #elif defined(ARDUINO_ARCH_SAMD) && defined(SERIAL_BUFFER_SIZE)
+        #define SSD1306_WIRE_BUFFER SERIAL_BUFFER_SIZE
+    #else
+        #define SSD1306_WIRE_BUFFER 32
+    #endif
+#endif
+
+/* Data bytes sent after each 0x40 control byte. Define SSD1306_WIRE_STREAM
+ * if Wire can take a whole page in one transaction (DMA backed cores, or a
+ * buffer enlarged with Wire.setBufferSize()).
+ */
+#ifdef SSD1306_WIRE_STREAM
+    #define SSD1306_DATA_BURST 255
+#elif SSD1306_WIRE_BUFFER > 256
+    #define SSD1306_DATA_BURST 255
+#else
+    #define SSD1306_DATA_BURST (SSD1306_WIRE_BUFFER - 1)
+#endif
+
+// Command bytes packed after a 0x00 control byte: they're queued in Wire's
+// buffer, so they always have to fit it, streaming or not.
+#if SSD1306_WIRE_BUFFER > 256
+    #define SSD1306_COMMAND_BURST 255
+#else
+    #define SSD1306_COMMAND_BURST (SSD1306_WIRE_BUFFER - 1)
+#endif
+
+/* I2C controllers with a control byte in front of each transmission, 0x00
+ * for commands and 0x40 for data (SSD1306, SH1106...).
+ *
+ * Commands are packed after a single control byte into the same
+ * transmission, until the Wire buffer is full or flush() is called. Data
+ * goes in transmissions as large as the Wire buffer allows.
+ *
+ * Panels sharing the bus each get their own LightI2CBus, with their
+ * address and clock. The clock is set by begin(), and again by
+ * beginTransfer() only if another LightI2CBus set its own in between.
+ */
+class LightI2CBus : public LightLCDBus {
+    public:
+        LightI2CBus(uint8_t address = 0x3C, uint32_t clock = 400000, TwoWire &wire = Wire)
+            : wire(wire), clock(clock), address(address), queued(0) {}
+
+        void begin() {
+            wire.begin();
+            wire.setClock(clock);
+
+            clocked() = this;
+        }
+
+        void beginTransfer() {
+            if (clocked() == this)
+                return;
+
+            wire.setClock(clock);
+            clocked() = this;
+        }
+
+        void command(uint8_t cmd) {
+            if (queued == SSD1306_COMMAND_BURST)
+                flush();
+
+            if (queued == 0) {
+                wire.beginTransmission(address);
+                wire.write(0x00);
+
+                LIGHTBUS_STAT(transactions++);
+                LIGHTBUS_STAT(busBytes++);
+            }
+
+            wire.write(cmd);
+            queued++;
+
+            LIGHTBUS_STAT(busBytes++);
+        }
+
+        void data(const uint8_t *data, uint8_t len) {
+            flush();
+
+            while (len) {
+                uint8_t burst = len < SSD1306_DATA_BURST ? len : SSD1306_DATA_BURST;
+
+                wire.beginTransmission(address);
+                wire.write(0x40);
+                wire.write(data, burst);
+                wire.endTransmission();
+
+                LIGHTBUS_STAT(transactions++);
+                LIGHTBUS_STAT(busBytes += burst + 1);
+
+                data += burst;
+                len  -= burst;
+            }
+        }
+
+        void flush() {
+            if (queued == 0)
+                return;
+
+            wire.endTransmission();
+            queued = 0;
+        }
+
+        uint8_t getAddress() { return address; }
+
+    protected:
+        TwoWire &wire;
+        uint32_t clock;
+        uint8_t  address;
+
+        // Command bytes in the open transmission
+        uint8_t  queued;
+
+        // Bus whose clock was set last, shared by all of them
+        static LightI2CBus *&clocked() {
+            static LightI2CBus *bus = NULL;
+            return bus;
+        }
+};
+
+#endif
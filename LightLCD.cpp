@@ -11,111 +11,1390 @@
 #include "LightLCD.h"
 #include "glcdfont.h"
 
-#define swap(a, b) { uint8_t t = a; a = b; b = t; }
+#define swap(a, b) { int16_t t = a; a = b; b = t; }
 
 // Variable width() font table
 //extern const uint8_t font[];
 
+// Each nibble with every bit doubled, to stretch font columns for size 2 and 4
+static const uint8_t doubled_nibble[16] PROGMEM = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF
+};
+
+static uint16_t doubleBits(uint8_t bits) {
+    return pgm_read_byte(doubled_nibble + (bits & 0x0F)) |
+           pgm_read_byte(doubled_nibble + (bits >> 4)) << 8;
+}
+
+// Repeat each of the 7 font bits `size` times (size 1 to 4)
+static uint32_t stretchBits(uint8_t bits, uint8_t size) {
+    if (size == 1)
+        return bits;
+
+    if (size == 2)
+        return doubleBits(bits);
+
+    if (size == 4) {
+        uint16_t d = doubleBits(bits);
+        return doubleBits(d & 0xFF) | (uint32_t)doubleBits(d >> 8) << 16;
+    }
+
+    uint32_t out = 0;
+
+    for (uint8_t b = 0; b < 7; b++)
+        if (bits & (1 << b))
+            out |= (uint32_t)((1 << size) - 1) << (b * size);
+
+    return out;
+}
+
+// ############################################################################################
+
+LightLCD::LightLCD(uint8_t *buffer, PageSpan *dirty, uint8_t stripPages) : buffer(buffer), dirty(dirty),
+    strip_first(0), strip_pages(stripPages), shadow(NULL), skipped(0), shadow_stale(0), flush_page(0xFF) {
+    raster_op = ROP_COPY;
+    sprites = NULL;
+
+    // The size isn't known yet: drivers call resetClip() once it is
+    origin_x = 0;
+    origin_y = 0;
+    clip_x0 = clip_y0 = 0;
+    clip_x1 = clip_y1 = 0xFF;
+
+    cursor_y = 0;
+    cursor_x = 0;
+    text_scroll = false;
+    
+    text_prop = { 1, 1, 1 };
+
+    LIGHTLCD_STAT(resetStats());
+}
+
+// ############################################################################################
+
+void LightLCD::resetLimits(uint8_t whole = true) {
+    if (dirty == NULL)
+        return;
+
+    uint8_t pages = height() / 8;
+
+    for (uint8_t p = 0; p < pages; p++) {
+        dirty[p].x0 = whole ? 0 : 0xFF;
+        dirty[p].x1 = whole ? width() - 1 : 0;
+    }
+}
+
+void LightLCD::expandLimits(uint8_t x, uint8_t y) {
+    if (dirty == NULL)
+        return;
+
+    PageSpan &span = dirty[y / 8];
+
+    if (x < span.x0) span.x0 = x;
+    if (x > span.x1) span.x1 = x;
+}
+
+void LightLCD::expandLimits(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+    if (dirty == NULL)
+        return;
+
+    for (uint8_t p = y0 / 8; p <= y1 / 8; p++) {
+        if (x0 < dirty[p].x0) dirty[p].x0 = x0;
+        if (x1 > dirty[p].x1) dirty[p].x1 = x1;
+    }
+}
+
+void LightLCD::invalidatePages(uint8_t first, uint8_t last) {
+    uint8_t pages = height() / 8;
+    uint8_t w     = width();
+
+    if (last >= pages)
+        last = pages - 1;
+
+    expandLimits(0, first * 8, w - 1, last * 8);
+
+    // Whatever the shadow holds for them, send them as they are
+    for (uint8_t p = first; p <= last; p++)
+        shadow_stale |= (uint32_t)1 << p;
+}
+
+void LightLCD::update() {
+    beginUpdate();
+    pollUpdate(0xFFFF);
+}
+
+void LightLCD::beginUpdate() {
+    drawSprites();
+
+    flush_page = 0;
+
+    LIGHTLCD_STAT(stats.updates++);
+}
+
+bool LightLCD::pollUpdate(uint16_t maxBytes) {
+    if (dirty == NULL)
+        return true;
+
+    LIGHTLCD_STAT(unsigned long start = micros());
+
+    uint8_t pages = height() / 8;
+    uint8_t sending = false;
+
+    while (flush_page < pages && maxBytes > 0) {
+        uint8_t   p    = flush_page;
+        PageSpan &span = dirty[p];
+
+        if (span.x0 > span.x1 || pageBuffer(p) == NULL) {
+            span.x0 = 0xFF;
+            span.x1 = 0;
+            flush_page++;
+            continue;
+        }
+
+        uint8_t x0 = span.x0;
+        uint8_t x1 = span.x1;
+
+        // Send what fits, and leave the rest of the span for the next call
+        if (x1 - x0 + 1 > maxBytes)
+            x1 = x0 + maxBytes - 1;
+
+        if (x1 == span.x1) {
+            span.x0 = 0xFF;
+            span.x1 = 0;
+            flush_page++;
+        } else {
+            span.x0 = x1 + 1;
+        }
+
+        maxBytes -= x1 - x0 + 1;
+
+        LIGHTLCD_STAT(stats.dirtyBytes += x1 - x0 + 1);
+
+        if (!sending) {
+            beginTransfer();
+            sending = true;
+        }
+
+        if (shadow) {
+            sendChanged(p, x0, x1);
+
+            // All of its dirty columns are out, the shadow matches again
+            if (flush_page > p)
+                shadow_stale &= ~((uint32_t)1 << p);
+        } else {
+            sendPage(p, x0, x1);
+        }
+    }
+
+    if (sending)
+        endTransfer();
+
+    LIGHTLCD_STAT(stats.updateMicros += micros() - start);
+
+    return flush_page >= pages;
+}
+
+bool LightLCD::pollUpdateFor(uint16_t maxMicros) {
+    unsigned long start = micros();
+
+    // Small slices, so the deadline is not overrun by much
+    while (!pollUpdate(16))
+        if (micros() - start >= maxMicros)
+            return false;
+
+    return true;
+}
+
+void LightLCD::firstPage() {
+    strip_first = 0;
+    clear();
+}
+
+bool LightLCD::nextPage() {
+    uint8_t pages = height() / 8;
+
+    if (strip_pages >= pages) {
+        update();
+        return false;
+    }
+
+    // The strip is sent whole, dirty spans don't matter here
+    beginTransfer();
+
+    for (uint8_t p = strip_first; p < strip_first + strip_pages && p < pages; p++) {
+        sendPage(p, 0, width() - 1);
+
+        if (shadow && pageBuffer(p)) {
+            memcpy(shadow + p * width(), pageBuffer(p), width());
+            shadow_stale &= ~((uint32_t)1 << p);
+        }
+    }
+
+    endTransfer();
+
+    strip_first += strip_pages;
+
+    if (strip_first >= pages)
+        strip_first = 0;
+
+    clear();
+
+    return strip_first != 0;
+}
+
+void LightLCD::drawPages(void (*draw)(LightLCD &lcd)) {
+    firstPage();
+
+    do {
+        draw(*this);
+    } while (nextPage());
+}
+
+void LightLCD::sendChanged(uint8_t page, uint8_t x0, uint8_t x1) {
+    uint8_t *cur = pageBuffer(page);
+    uint8_t *old = shadow + page * width();
+
+    uint8_t sent = 0;
+    int x = x0;
+
+    if (shadow_stale & ((uint32_t)1 << page)) {
+        sendPage(page, x0, x1);
+        memcpy(old + x0, cur + x0, x1 - x0 + 1);
+        return;
+    }
+
+    while (x <= x1) {
+        // Skip what the panel already shows
+        while (x <= x1 && cur[x] == old[x])
+            x++;
+
+        if (x > x1)
+            break;
+
+        // Grow the run until diff_gap unchanged bytes in a row are found
+        uint8_t start = x, end = x, same = 0;
+
+        for (; x <= x1 && same < diff_gap; x++) {
+            if (cur[x] != old[x]) {
+                end  = x;
+                same = 0;
+            } else {
+                same++;
+            }
+        }
+
+        sendPage(page, start, end);
+        memcpy(old + start, cur + start, end - start + 1);
+
+        sent += end - start + 1;
+    }
+
+    skipped += (x1 - x0 + 1) - sent;
+}
+
+void LightLCD::setShadowBuffer(uint8_t *shadow, uint8_t granularity) {
+    this->shadow = shadow;
+    diff_gap = granularity ? granularity : 1;
+
+    if (shadow == NULL || buffer == NULL)
+        return;
+
+    // The panel shows the framebuffer but for the dirty columns, which can't
+    // be compared: they are sent as they are the first time.
+    uint8_t pages = height() / 8;
+    uint8_t w     = width();
+
+    for (uint8_t p = 0; p < pages; p++) {
+        uint8_t *cur = pageBuffer(p);
+
+        if (cur != NULL)
+            memcpy(shadow + p * w, cur, w);
+    }
+
+    shadow_stale = 0xFFFFFFFF;
+}
+
+unsigned long LightLCD::getSkippedBytes() { return skipped; }
+void LightLCD::resetSkippedBytes()        { skipped = 0; }
+
+#ifdef LIGHTLCD_STATS
+void LightLCD::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void LightLCD::printStats(Print &out) {
+    unsigned long n = stats.updates ? stats.updates : 1;
+
+    out.print(F("pixels "));      out.println(stats.pixels);
+    out.print(F("primitives "));  out.println(stats.primitives);
+    out.print(F("updates "));     out.println(stats.updates);
+    out.print(F("dirty/upd "));   out.println(stats.dirtyBytes / n);
+    out.print(F("bytes/upd "));   out.println(stats.busBytes / n);
+    out.print(F("trans/upd "));   out.println(stats.transactions / n);
+    out.print(F("us/upd "));      out.println(stats.updateMicros / n);
+}
+#endif
+
 // ############################################################################################
 
-LightLCD::LightLCD() {
-    cursor_y = 0;
-    cursor_x = 0;
-    
-    text_prop = { 1, 1, 1 };
+void LightLCD::setClipRect(int16_t x, int16_t y, uint8_t w, uint8_t h) {
+    int16_t ww = w;
+    int16_t hh = h;
+
+    x += origin_x;
+    y += origin_y;
+
+    // Never past the screen, so what's clipped can be drawn unchecked
+    clip_x0 = 0;
+    clip_y0 = 0;
+    clip_x1 = width() - 1;
+    clip_y1 = height() - 1;
+
+    if (!clipArea(x, y, ww, hh)) {
+        clip_x0 = 1;
+        clip_x1 = 0;
+        return;
+    }
+
+    clip_x0 = x;
+    clip_y0 = y;
+    clip_x1 = x + ww - 1;
+    clip_y1 = y + hh - 1;
+}
+
+void LightLCD::setViewport(int16_t x, int16_t y, uint8_t w, uint8_t h) {
+    origin_x = 0;
+    origin_y = 0;
+
+    setClipRect(x, y, w, h);
+
+    origin_x = x;
+    origin_y = y;
+}
+
+void LightLCD::setOrigin(int16_t x, int16_t y) {
+    origin_x = x;
+    origin_y = y;
+}
+
+// Set directly, a 256 pixels wide canvas doesn't fit setClipRect()
+void LightLCD::resetClip() {
+    origin_x = 0;
+    origin_y = 0;
+
+    clip_x0 = 0;
+    clip_y0 = 0;
+    clip_x1 = width() - 1;
+    clip_y1 = height() - 1;
+}
+
+void    LightLCD::setRasterOp(uint8_t op) { raster_op = op; }
+uint8_t LightLCD::getRasterOp()           { return raster_op; }
+
+void LightLCD::drawPixel(int16_t x, int16_t y, uint8_t color) {
+    plot(x + origin_x, y + origin_y, color);
+}
+
+void LightLCD::plot(int16_t x, int16_t y, uint8_t color) {
+    if (x < clip_x0 || x > clip_x1 || y < clip_y0 || y > clip_y1)
+        return;
+
+    putPixel(x, y, color);
+}
+
+void LightLCD::drawVLine(int16_t x, int16_t y, uint8_t h, uint8_t color) {
+    fillRect(x, y, 1, h, color);
+}
+void LightLCD::drawHLine(int16_t x, int16_t y, uint8_t w, uint8_t color) {
+    fillRect(x, y, w, 1, color);
+}
+
+/* Cohen-Sutherland style: lines with both ends on the same outer side are
+ * dropped, lines with both ends inside are drawn as they are. The others
+ * skip straight to the first visible step, with the Bresenham state it
+ * would have there, so a clipped line has the same pixels as a whole one.
+ */
+bool LightLCD::clipLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, LineWalk &walk, uint8_t withEnd) {
+    uint8_t out0 = (x0 < clip_x0) | (x0 > clip_x1) << 1 | (y0 < clip_y0) << 2 | (y0 > clip_y1) << 3;
+    uint8_t out1 = (x1 < clip_x0) | (x1 > clip_x1) << 1 | (y1 < clip_y0) << 2 | (y1 > clip_y1) << 3;
+
+    if (out0 & out1)
+        return false;
+
+    // Clip bounds along the walk (x) and across it (y)
+    int16_t lo_x = clip_x0, hi_x = clip_x1;
+    int16_t lo_y = clip_y0, hi_y = clip_y1;
+
+    walk.steep = abs(y1 - y0) > abs(x1 - x0);
+
+    if (walk.steep) {
+        swap(x0, y0);
+        swap(x1, y1);
+        swap(lo_x, lo_y);
+        swap(hi_x, hi_y);
+    }
+
+    uint8_t reversed = x0 > x1;
+
+    if (reversed) {
+        swap(x0, x1);
+        swap(y0, y1);
+    }
+
+    int16_t dx   = x1 - x0;
+    int16_t dy   = abs(y1 - y0);
+    int16_t err0 = dx / 2;
+
+    walk.dx    = dx;
+    walk.dy    = dy;
+    walk.ystep = y0 < y1 ? 1 : -1;
+
+    // Step k is at x0 + k, and has moved q(k) = (k*dy - err0 + dx - 1) / dx
+    // times along y: find the steps inside the clip rectangle.
+    int32_t first = lo_x - x0 > 0 ? lo_x - x0 : 0;
+    int32_t last  = hi_x - x0 < dx ? hi_x - x0 : dx;
+
+    if (!withEnd) {
+        if (reversed)
+            first = first > 1 ? first : 1;
+        else
+            last = last < dx - 1 ? last : dx - 1;
+    }
+
+    if (out0 | out1) {
+        // Moves along y allowed, before entering and before leaving
+        int32_t qa = walk.ystep > 0 ? lo_y - y0 : y0 - hi_y;
+        int32_t qb = walk.ystep > 0 ? hi_y - y0 : y0 - lo_y;
+
+        if (qb < 0 || (qa > 0 && dy == 0))
+            return false;
+
+        if (qa > 0) {
+            int32_t k = (qa * dx + err0 - dx + 1 + dy - 1) / dy;
+            if (k > first) first = k;
+        }
+
+        if (dy > 0) {
+            int32_t k = (qb * dx + err0) / dy;
+            if (k < last) last = k;
+        }
+    }
+
+    if (first > last)
+        return false;
+
+    int32_t q = dx ? (first * dy - err0 + dx - 1) / dx : 0;
+
+    walk.x     = x0 + first;
+    walk.y     = y0 + walk.ystep * q;
+    walk.err   = err0 - first * dy + q * dx;
+    walk.count = last - first;
+
+    return true;
+}
+
+void LightLCD::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color) {
+    LineWalk l;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    if (clipLine(x0 + origin_x, y0 + origin_y, x1 + origin_x, y1 + origin_y, l))
+        walkLine(l, color);
+}
+
+/* Run-slice: the steps between two moves across the walk make a run, drawn
+ * at once as a span (a row along a page, or bits of one byte per page when
+ * steep). Runs are dx / dy or one step longer, the remainder deciding
+ * which as in Bresenham, so only the first one needs a division.
+ */
+void LightLCD::walkLine(LineWalk &l, uint8_t color) {
+    uint16_t left = l.count + 1;
+    uint16_t run  = left;
+    uint16_t whole = 0;
+    int16_t  rem = 0, frac = 0;
+
+    if (l.dy > 0) {
+        whole = l.dx / l.dy;
+        rem   = l.dx % l.dy;
+        run   = l.err / l.dy + 1;
+        frac  = l.err % l.dy;
+    }
+
+    for (;;) {
+        if (run > left)
+            run = left;
+
+        if (l.steep)
+            fillSpan(l.y, l.x, 1, run, color);
+        else
+            fillSpan(l.x, l.y, run, 1, color);
+
+        left -= run;
+
+        if (left == 0)
+            break;
+
+        l.x += run;
+        l.y += l.ystep;
+
+        run   = whole;
+        frac += rem;
+
+        if (frac >= l.dy) {
+            frac -= l.dy;
+            run++;
+        }
+    }
+}
+
+/* Joined lines: each one stops before the next starts, so corners are drawn
+ * once (and XOR leaves them set).
+ */
+void LightLCD::drawPolyline(const int16_t *points, uint8_t count, uint8_t color) {
+    LineWalk l;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    if (count == 1)
+        plot(points[0] + origin_x, points[1] + origin_y, color);
+
+    for (uint8_t i = 1; i < count; i++, points += 2)
+        if (clipLine(points[0] + origin_x, points[1] + origin_y, points[2] + origin_x, points[3] + origin_y, l, i == count - 1))
+            walkLine(l, color);
+}
+
+void LightLCD::drawPolyline(int16_t x, uint8_t step, const uint8_t *ys, uint8_t count, uint8_t color) {
+    LineWalk l;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x += origin_x;
+
+    if (count == 1)
+        plot(x, ys[0] + origin_y, color);
+
+    for (uint8_t i = 1; i < count; i++, x += step)
+        if (clipLine(x, ys[i - 1] + origin_y, x + step, ys[i] + origin_y, l, i == count - 1))
+            walkLine(l, color);
+}
+
+/* The pixels of a line, the same ones drawLine() sets, a column at a time
+ * from left to right: steep lines give a run of rows in each column.
+ * Lines walked right to left by Bresenham are walked back from their end,
+ * undoing its steps exactly.
+ */
+struct ColumnWalk {
+    int16_t x, y;       // Pixel of step k
+    int16_t n, m, err;  // Steps, moves across them, error at step k
+    int16_t k;
+    int8_t  xstep;
+    uint8_t steep, back;
+
+    void begin(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+        steep = abs(y1 - y0) > abs(x1 - x0);
+
+        // Same normalization as LightLCD::clipLine()
+        if (steep ? y0 > y1 : x0 > x1) {
+            swap(x0, x1);
+            swap(y0, y1);
+        }
+
+        n = steep ? y1 - y0 : x1 - x0;
+        m = steep ? abs(x1 - x0) : abs(y1 - y0);
+
+        xstep = steep ? (x0 < x1 ? 1 : -1) : (y0 < y1 ? 1 : -1);
+        back  = steep && xstep < 0;
+
+        x = x0;
+        y = y0;
+        k = 0;
+        err = n / 2;
+
+        if (back) {
+            // Jump to the last step: q moves made by then
+            int32_t q = n ? ((int32_t)n * m - err + n - 1) / n : 0;
+
+            err = err - (int32_t)n * m + q * n;
+            x   = x1;
+            y   = y1;
+            k   = n;
+        }
+    }
+
+    // Next column, with its rows top..bot. False when done.
+    bool next(int16_t &col, int16_t &top, int16_t &bot) {
+        if (k < 0 || k > n)
+            return false;
+
+        col = x;
+
+        if (!steep) {
+            top = bot = y;
+
+            k++;
+            err -= m;
+
+            if (err < 0) {
+                y   += xstep;
+                err += n;
+            }
+
+            x++;
+            return true;
+        }
+
+        top = bot = y;
+
+        // Walk the steps until the column changes
+        for (;;) {
+            if (back) {
+                if (--k < 0)
+                    break;
+
+                y--;
+                err += m;
+
+                if (err >= n) {
+                    err -= n;
+                    x++;
+                    break;
+                }
+
+                top = y;
+            } else {
+                if (++k > n)
+                    break;
+
+                y++;
+                err -= m;
+
+                if (err < 0) {
+                    err += n;
+                    x += xstep;
+                    break;
+                }
+
+                bot = y;
+            }
+        }
+
+        return true;
+    }
+};
+
+void LightLCD::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color) {
+    LineWalk l;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x0 += origin_x; x1 += origin_x; x2 += origin_x;
+    y0 += origin_y; y1 += origin_y; y2 += origin_y;
+
+    if (x0 == x1 && x1 == x2 && y0 == y1 && y1 == y2) {
+        plot(x0, y0, color);
+        return;
+    }
+
+    if (raster_op == ROP_XOR || raster_op == ROP_INVERT) {
+        xorTriangle(x0, y0, x1, y1, x2, y2, color);
+        return;
+    }
+
+    // Each side stops before the next one starts
+    if (clipLine(x0, y0, x1, y1, l, false)) walkLine(l, color);
+    if (clipLine(x1, y1, x2, y2, l, false)) walkLine(l, color);
+    if (clipLine(x2, y2, x0, y0, l, false)) walkLine(l, color);
+}
+
+/* Sides can share more than the corners where they meet at a sharp angle,
+ * and toggling those pixels twice would leave them unchanged: the sides are
+ * walked together a column at a time, their rows merged and drawn once.
+ */
+void LightLCD::xorTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color) {
+    ColumnWalk side[3];
+    int16_t col[3], top[3], bot[3];
+    uint8_t live[3];
+
+    side[0].begin(x0, y0, x1, y1);
+    side[1].begin(x1, y1, x2, y2);
+    side[2].begin(x2, y2, x0, y0);
+
+    for (uint8_t i = 0; i < 3; i++)
+        live[i] = side[i].next(col[i], top[i], bot[i]);
+
+    while (live[0] || live[1] || live[2]) {
+        int16_t x = 0x7FFF;
+
+        for (uint8_t i = 0; i < 3; i++)
+            if (live[i] && col[i] < x)
+                x = col[i];
+
+        // Runs in this column, sorted by top
+        int16_t t[3], b[3];
+        uint8_t runs = 0;
+
+        for (uint8_t i = 0; i < 3; i++) {
+            if (!live[i] || col[i] != x)
+                continue;
+
+            uint8_t j = runs++;
+
+            for (; j > 0 && t[j - 1] > top[i]; j--) {
+                t[j] = t[j - 1];
+                b[j] = b[j - 1];
+            }
+
+            t[j] = top[i];
+            b[j] = bot[i];
+
+            live[i] = side[i].next(col[i], top[i], bot[i]);
+        }
+
+        // Merge the overlapping or touching ones
+        int16_t start = t[0], end = b[0];
+
+        for (uint8_t j = 1; j < runs; j++) {
+            if (t[j] <= end + 1) {
+                if (b[j] > end)
+                    end = b[j];
+            } else {
+                fillArea(x, start, 1, end - start + 1, color);
+                start = t[j];
+                end   = b[j];
+            }
+        }
+
+        fillArea(x, start, 1, end - start + 1, color);
+    }
+}
+
+// The sides are walked a column at a time as drawTriangle() draws them, and
+// each column is filled from the top to the bottom row they reach there: the
+// fill covers the outline, and no more.
+void LightLCD::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color) {
+    ColumnWalk side[3];
+    int16_t col[3], top[3], bot[3];
+    uint8_t live[3];
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x0 += origin_x; x1 += origin_x; x2 += origin_x;
+    y0 += origin_y; y1 += origin_y; y2 += origin_y;
+
+    side[0].begin(x0, y0, x1, y1);
+    side[1].begin(x1, y1, x2, y2);
+    side[2].begin(x2, y2, x0, y0);
+
+    for (uint8_t i = 0; i < 3; i++)
+        live[i] = side[i].next(col[i], top[i], bot[i]);
+
+    while (live[0] || live[1] || live[2]) {
+        int16_t x = 0x7FFF;
+        int16_t a = 0x7FFF, b = -0x7FFF;
+
+        for (uint8_t i = 0; i < 3; i++)
+            if (live[i] && col[i] < x)
+                x = col[i];
+
+        for (uint8_t i = 0; i < 3; i++) {
+            if (!live[i] || col[i] != x)
+                continue;
+
+            if (top[i] < a) a = top[i];
+            if (bot[i] > b) b = bot[i];
+
+            live[i] = side[i].next(col[i], top[i], bot[i]);
+        }
+
+        fillArea(x, a, 1, b - a + 1, color);
+    }
+}
+
+// Corners go with the horizontal sides, so each pixel is drawn once
+void LightLCD::drawRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color) {
+    if (w == 0 || h == 0)
+        return;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x += origin_x;
+    y += origin_y;
+
+    fillArea(x, y, w, 1, color);
+
+    if (h > 1)
+        fillArea(x, y+h-1, w, 1, color);
+
+    if (h > 2) {
+        fillArea(x, y+1, 1, h-2, color);
+
+        if (w > 1)
+            fillArea(x+w-1, y+1, 1, h-2, color);
+    }
+}
+
+void LightLCD::fillRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color) {
+    LIGHTLCD_STAT(stats.primitives++);
+
+    fillArea(x + origin_x, y + origin_y, w, h, color);
+}
+
+void LightLCD::fillArea(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color) {
+    // Clip once here, so the inner loops don't have to.
+    if (!clipArea(x, y, w, h))
+        return;
+
+    fillSpan(x, y, w, h, color);
+}
+
+void LightLCD::fillSpan(uint8_t x, uint8_t y, uint16_t w, uint16_t h, uint8_t color) {
+    LIGHTLCD_STAT(stats.pixels += (uint32_t)w * h);
+
+    if (buffer == NULL) {
+        // Counted from 0: x + w is 256 at the right edge of a wide canvas
+        for (uint16_t j = 0; j < h; j++)
+            for (uint16_t i = 0; i < w; i++)
+                putPixel(x + i, y + j, color);
+
+        return;
+    }
+
+    uint8_t y1 = y + h - 1;
+
+    for (uint8_t p = y / 8; p <= y1 / 8; p++) {
+        uint8_t *ptr = pageBuffer(p);
+
+        if (ptr != NULL)
+            fillColumns(ptr + x, w, pageMask(p, y, y1), color);
+    }
+
+    expandLimits(x, y, x + w - 1, y1);
+}
+
+// Midpoint circle: f tracks x^2 + y^2 - r^2 with additions only
+void LightLCD::drawArcs(int16_t cx, int16_t cy, uint8_t r, uint8_t corners, int16_t xgap, int16_t ygap, uint8_t color) {
+    int16_t f   = 1 - r;
+    int16_t ddx = 1;
+    int16_t ddy = -2 * r;
+    int16_t x   = 0;
+    int16_t y   = r;
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddy += 2;
+            f   += ddy;
+        }
+
+        x++;
+        ddx += 2;
+        f   += ddx;
+
+        // Past the diagonal the points were already drawn as the mirror ones,
+        // on the diagonal both octants give the same point
+        if (x > y)
+            break;
+
+        uint8_t both = x != y;
+
+        if (corners & 1) {
+            plot(cx - x, cy - y, color);
+            if (both) plot(cx - y, cy - x, color);
+        }
+        if (corners & 2) {
+            plot(cx + xgap + x, cy - y, color);
+            if (both) plot(cx + xgap + y, cy - x, color);
+        }
+        if (corners & 4) {
+            plot(cx + xgap + x, cy + ygap + y, color);
+            if (both) plot(cx + xgap + y, cy + ygap + x, color);
+        }
+        if (corners & 8) {
+            plot(cx - x, cy + ygap + y, color);
+            if (both) plot(cx - y, cy + ygap + x, color);
+        }
+    }
+}
+
+// Same walk as drawArcs, but each column gets a single span: the columns
+// near the center when x moves, the outer ones once y has moved past them.
+void LightLCD::fillArcs(int16_t cx, int16_t cy, uint8_t r, uint8_t sides, int16_t stretch, uint8_t color) {
+    int16_t f   = 1 - r;
+    int16_t ddx = 1;
+    int16_t ddy = -2 * r;
+    int16_t x   = 0;
+    int16_t y   = r;
+    int16_t px  = 0;
+    int16_t py  = r;
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddy += 2;
+            f   += ddy;
+        }
+
+        x++;
+        ddx += 2;
+        f   += ddx;
+
+        if (x <= y) {
+            if (sides & 1) fillArea(cx + x, cy - y, 1, 2 * y + 1 + stretch, color);
+            if (sides & 2) fillArea(cx - x, cy - y, 1, 2 * y + 1 + stretch, color);
+        }
+
+        if (y != py) {
+            if (sides & 1) fillArea(cx + py, cy - px, 1, 2 * px + 1 + stretch, color);
+            if (sides & 2) fillArea(cx - py, cy - px, 1, 2 * px + 1 + stretch, color);
+            py = y;
+        }
+
+        px = x;
+    }
+}
+
+void LightLCD::drawCircle(int16_t x0, int16_t y0, uint8_t r, uint8_t color) {
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x0 += origin_x;
+    y0 += origin_y;
+
+    plot(x0, y0 - r, color);
+
+    if (r == 0)
+        return;
+
+    plot(x0, y0 + r, color);
+    plot(x0 - r, y0, color);
+    plot(x0 + r, y0, color);
+
+    drawArcs(x0, y0, r, 0x0F, 0, 0, color);
+}
+
+void LightLCD::fillCircle(int16_t x0, int16_t y0, uint8_t r, uint8_t color) {
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x0 += origin_x;
+    y0 += origin_y;
+
+    fillArea(x0, y0 - r, 1, 2 * r + 1, color);
+    fillArcs(x0, y0, r, 0x03, 0, color);
+}
+
+void LightLCD::drawRoundRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color) {
+    if (w == 0 || h == 0)
+        return;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x += origin_x;
+    y += origin_y;
+
+    // Keep the right corners from crossing the left ones
+    uint8_t max_r = ((w < h ? w : h) - 1) / 2;
+    if (r > max_r) r = max_r;
+
+    // Straight sides between the corners, square corners go with the
+    // horizontal ones
+    uint8_t inset = r ? r : 1;
+
+    fillArea(x + r, y, w - 2 * r, 1, color);
+
+    if (h > 1)
+        fillArea(x + r, y + h - 1, w - 2 * r, 1, color);
+
+    if (h > 2 * inset) {
+        fillArea(x, y + inset, 1, h - 2 * inset, color);
+
+        if (w > 1)
+            fillArea(x + w - 1, y + inset, 1, h - 2 * inset, color);
+    }
+
+    if (r > 0)
+        drawArcs(x + r, y + r, r, 0x0F, w - 2 * r - 1, h - 2 * r - 1, color);
+}
+
+void LightLCD::fillRoundRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color) {
+    if (w == 0 || h == 0)
+        return;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x += origin_x;
+    y += origin_y;
+
+    // Keep the right corners from crossing the left ones
+    uint8_t max_r = ((w < h ? w : h) - 1) / 2;
+    if (r > max_r) r = max_r;
+
+    fillArea(x + r, y, w - 2 * r, h, color);
+
+    if (r > 0) {
+        int16_t stretch = h - 2 * r - 1;
+
+        fillArcs(x + w - r - 1, y + r, r, 0x01, stretch, color);
+        fillArcs(x + r, y + r, r, 0x02, stretch, color);
+    }
 }
 
 // ############################################################################################
 
-void LightLCD::resetLimits(uint8_t whole = true) {
-    limits.x0 = 0;
-    limits.x1 = whole ? width() - 1 : 0;
-    limits.y0 = 0;
-    limits.y1 = whole ? height() - 1 : 0;
+void LightLCD::addSprite(LightSprite &s, const uint8_t *bitmap, const uint8_t *mask, uint8_t w, uint8_t h, uint8_t *under) {
+    s.bitmap  = bitmap;
+    s.mask    = mask;
+    s.under   = under;
+    s.w       = w;
+    s.h       = h;
+    s.x       = 0;
+    s.y       = 0;
+    s.visible = true;
+    s.shown   = false;
+    s.changed = true;
+    s.next    = NULL;
+
+    LightSprite **last = &sprites;
+
+    while (*last)
+        last = &(*last)->next;
+
+    *last = &s;
 }
 
-void LightLCD::expandLimits(uint8_t x, uint8_t y) {
-         if (x < limits.x0) limits.x0 = x;
-    else if (x > limits.x1) limits.x1 = x;
+void LightLCD::removeSprite(LightSprite &s) {
+    showSprite(s, false);
+    drawSprites();
 
-         if (y < limits.y0) limits.y0 = y;
-    else if (y > limits.y1) limits.y1 = y;
+    for (LightSprite **link = &sprites; *link; link = &(*link)->next)
+        if (*link == &s) {
+            *link = s.next;
+            break;
+        }
 }
 
-// ############################################################################################
+void LightLCD::moveSprite(LightSprite &s, int16_t x, int16_t y) {
+    if (x == s.x && y == s.y)
+        return;
 
-void LightLCD::drawVLine(uint8_t x, uint8_t y, uint8_t h, uint8_t color) {
-    for(int i = 0; i < h; i++)
-        drawPixel(x, y + i, color);
+    s.x = x;
+    s.y = y;
+    s.changed = true;
 }
-void LightLCD::drawHLine(uint8_t x, uint8_t y, uint8_t w, uint8_t color) {
-    for(int i = 0; i < w; i++)
-        drawPixel(x + i, y, color);
+
+// Same size as the old image: under was sized for it
+void LightLCD::setSpriteImage(LightSprite &s, const uint8_t *bitmap, const uint8_t *mask) {
+    s.bitmap  = bitmap;
+    s.mask    = mask;
+    s.changed = true;
 }
 
-void LightLCD::drawLine(uint8_t x0, uint8_t y0,  uint8_t x1, uint8_t y1,  uint8_t color) {
-    uint8_t steep = abs(y1 - y0) > abs(x1 - x0);
-    
-    if (steep) {
-        swap(x0, y0);
-        swap(x1, y1);
+void LightLCD::showSprite(LightSprite &s, uint8_t visible) {
+    if (s.visible == visible)
+        return;
+
+    s.visible = visible;
+    s.changed = true;
+}
+
+// Rectangle a sprite covers now and/or will cover, false if neither
+static bool spriteBounds(const LightSprite &s, int16_t &x0, int16_t &y0, int16_t &x1, int16_t &y1) {
+    if (!s.shown && !s.visible)
+        return false;
+
+    x0 = s.shown ? s.shown_x : s.x;
+    y0 = s.shown ? s.shown_y : s.y;
+    x1 = x0;
+    y1 = y0;
+
+    if (s.visible) {
+        if (s.x < x0) x0 = s.x;
+        if (s.y < y0) y0 = s.y;
+        if (s.x > x1) x1 = s.x;
+        if (s.y > y1) y1 = s.y;
     }
 
-    if (x0 > x1) {
-        swap(x0, x1);
-        swap(y0, y1);
+    x1 += s.w - 1;
+    y1 += s.h - 1;
+
+    return true;
+}
+
+static bool spritesOverlap(const LightSprite &a, const LightSprite &b) {
+    int16_t ax0, ay0, ax1, ay1;
+    int16_t bx0, by0, bx1, by1;
+
+    if (!spriteBounds(a, ax0, ay0, ax1, ay1) || !spriteBounds(b, bx0, by0, bx1, by1))
+        return false;
+
+    return ax0 <= bx1 && bx0 <= ax1 && ay0 <= by1 && by0 <= ay1;
+}
+
+/* Sprites come off the framebuffer top first, so each one gives back what
+ * was there when it was drawn, then go back on bottom first. Sprites over
+ * a changed one that overlap it take part too, they're drawn over it.
+ */
+void LightLCD::drawSprites() {
+    if (sprites == NULL || buffer == NULL || strip_pages < height() / 8)
+        return;
+
+    for (LightSprite *s = sprites->next; s; s = s->next)
+        for (LightSprite *t = sprites; t != s && !s->changed; t = t->next)
+            if (t->changed && spritesOverlap(*s, *t))
+                s->changed = true;
+
+    // Compositing works on the whole screen, whatever the drawing state
+    int16_t ox = origin_x, oy = origin_y;
+    uint8_t cx0 = clip_x0, cy0 = clip_y0, cx1 = clip_x1, cy1 = clip_y1;
+    uint8_t op = raster_op;
+
+    resetClip();
+    raster_op = ROP_COPY;
+
+    restoreSprites(sprites);
+
+    for (LightSprite *s = sprites; s; s = s->next) {
+        if (!s->changed)
+            continue;
+
+        s->changed = false;
+        s->shown   = s->visible;
+
+        if (!s->visible)
+            continue;
+
+        s->shown_x = s->x;
+        s->shown_y = s->y;
+
+        copyUnder(*s, true);
+
+        LIGHTLCD_STAT(stats.primitives++);
+
+        blitPages(s->x, s->y, s->bitmap, s->mask, s->w, s->h, BLACK, false);
     }
 
-    uint8_t dx, dy;
-    dx = x1 - x0;
-    dy = abs(y1 - y0);
+    origin_x = ox;
+    origin_y = oy;
+    clip_x0 = cx0;
+    clip_y0 = cy0;
+    clip_x1 = cx1;
+    clip_y1 = cy1;
+    raster_op = op;
+}
 
-    int8_t err   = dx / 2;
-    int8_t ystep = y0 < y1 ? 1 : -1;
+void LightLCD::hideSprites() {
+    if (buffer == NULL || strip_pages < height() / 8)
+        return;
 
-    for (; x0 <= x1; x0++) {
-        if (steep)
-            drawPixel(y0, x0, color);
-        else
-            drawPixel(x0, y0, color);
-        
-        err -= dy;
-    
-        if (err < 0) {
-            y0 += ystep;
-            err += dx;
+    for (LightSprite *s = sprites; s; s = s->next)
+        s->changed = true;
+
+    restoreSprites(sprites);
+    dropSprites();
+}
+
+// Put back the background of the changed sprites from s up, top first
+void LightLCD::restoreSprites(LightSprite *s) {
+    if (s == NULL)
+        return;
+
+    restoreSprites(s->next);
+
+    if (s->changed && s->shown)
+        copyUnder(*s, false);
+}
+
+// Save the framebuffer under a shown sprite (the part on screen), or put it
+// back and mark it dirty
+void LightLCD::copyUnder(LightSprite &s, uint8_t save) {
+    int16_t x0 = s.shown_x > 0 ? s.shown_x : 0;
+    int16_t y0 = s.shown_y > 0 ? s.shown_y : 0;
+    int16_t x1 = s.shown_x + s.w - 1 < width()  ? s.shown_x + s.w - 1 : width() - 1;
+    int16_t y1 = s.shown_y + s.h - 1 < height() ? s.shown_y + s.h - 1 : height() - 1;
+
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    for (uint8_t p = y0 / 8; p <= y1 / 8; p++) {
+        uint8_t *ptr  = pageBuffer(p);
+        uint8_t *keep = s.under + (p - (s.shown_y >> 3)) * s.w - s.shown_x;
+        uint8_t  mask = pageMask(p, y0, y1);
+
+        for (uint8_t x = x0; x <= x1; x++) {
+            if (save)
+                keep[x] = ptr[x];
+            else
+                ptr[x] = (ptr[x] & ~mask) | (keep[x] & mask);
         }
     }
+
+    if (!save)
+        expandLimits(x0, y0, x1, y1);
+}
+
+// The framebuffer was cleared: the sprites aren't on it any more
+void LightLCD::dropSprites() {
+    for (LightSprite *s = sprites; s; s = s->next) {
+        s->shown   = false;
+        s->changed = true;
+    }
+}
+
+// ############################################################################################
+
+void LightLCD::setupChart(LightChart &c, int16_t x, int16_t y, uint8_t w, uint8_t h, int16_t lo, int16_t hi, uint8_t samplesPerColumn) {
+    int16_t ww = w;
+    int16_t hh = h;
+
+    x += origin_x;
+    y += origin_y;
+
+    // Nothing to shift without a framebuffer
+    if (!clipArea(x, y, ww, hh) || buffer == NULL)
+        ww = hh = 0;
+
+    c.x  = x;
+    c.y  = y;
+    c.w  = ww;
+    c.h  = hh;
+    c.lo = lo;
+    c.hi = hi > lo ? hi : lo + 1;
+    c.samples_per_column = samplesPerColumn ? samplesPerColumn : 1;
+    c.filled = false;
+
+    clearChart(c);
+}
+
+void LightLCD::clearChart(LightChart &c) {
+    c.count = 0;
+    c.last  = 0xFF;
+
+    if (c.w > 0)
+        shiftLeft(c.x, c.y, c.w, c.h, c.w);
+}
+
+void LightLCD::addChartSample(LightChart &c, int16_t value) {
+    addChartSamples(c, &value, 1);
+}
+
+/* The chart moves once for all the columns the samples complete, then each
+ * is drawn in the space left on the right (those pushed out at once are
+ * only followed, for the trace to join).
+ */
+void LightLCD::addChartSamples(LightChart &c, const int16_t *values, uint8_t count) {
+    uint16_t cols = (c.count + count) / c.samples_per_column;
+
+    if (c.w == 0)
+        return;
+
+    if (cols > 0)
+        shiftLeft(c.x, c.y, c.w, c.h, cols < c.w ? cols : c.w);
+
+    // Where the next completed column goes, may start left of the chart
+    int16_t x = c.x + c.w - (int16_t)cols;
+
+    for (uint8_t i = 0; i < count; i++) {
+        int16_t v = values[i];
+
+        if (c.count == 0 || v < c.min) c.min = v;
+        if (c.count == 0 || v > c.max) c.max = v;
+
+        if (++c.count < c.samples_per_column)
+            continue;
+
+        drawChartColumn(c, x >= c.x ? x : 0xFF, v);
+
+        c.count = 0;
+        x++;
+    }
 }
 
-void LightLCD::drawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color) {
-    drawHLine(x, y, w, color);
-    drawHLine(x, y+h-1, w, color);
-    drawVLine(x, y, h, color);
-    drawVLine(x+w-1, y, h, color);
+// Row of value in the chart, clamped to it
+static uint8_t chartRow(const LightChart &c, int16_t value) {
+    if (value < c.lo) value = c.lo;
+    if (value > c.hi) value = c.hi;
+
+    // Ranges can span more than int16_t
+    return c.y + c.h - 1 - ((int32_t)value - c.lo) * (c.h - 1) / ((int32_t)c.hi - c.lo);
+}
+
+// Draw the gathered range at column x (0xFF to only move the trace on),
+// joined to where the previous column left off
+void LightLCD::drawChartColumn(LightChart &c, uint8_t x, int16_t lastValue) {
+    uint8_t top = chartRow(c, c.max);
+    uint8_t bot = chartRow(c, c.min);
+
+    if (c.last != 0xFF) {
+        if (c.last < top) top = c.last;
+        if (c.last > bot) bot = c.last;
+    }
+
+    if (c.filled)
+        bot = c.y + c.h - 1;
+
+    c.last = chartRow(c, lastValue);
+
+    if (x == 0xFF)
+        return;
+
+    // The trace is BLACK whatever the drawing state
+    uint8_t op = raster_op;
+
+    raster_op = ROP_COPY;
+    fillSpan(x, top, 1, bot - top + 1, BLACK);
+    raster_op = op;
 }
 
-void LightLCD::fillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color) {
-    for (uint8_t i = x; i < x+w; i++) {
-        drawVLine(i, y, h, color); 
+void LightLCD::shiftLeft(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t cols) {
+    uint8_t y1   = y + h - 1;
+    uint8_t keep = cols < w ? w - cols : 0;
+
+    for (uint8_t p = y / 8; p <= y1 / 8; p++) {
+        uint8_t *ptr  = pageBuffer(p);
+        uint8_t  mask = pageMask(p, y, y1);
+
+        if (ptr == NULL)
+            continue;
+
+        ptr += x;
+
+        if (mask == 0xFF) {
+            memmove(ptr, ptr + cols, keep);
+            memset(ptr + keep, 0, w - keep);
+            continue;
+        }
+
+        // Rows of the page outside the chart stay where they are
+        for (uint8_t i = 0; i < w; i++)
+            ptr[i] = (ptr[i] & ~mask) | (i < keep ? ptr[i + cols] & mask : 0);
     }
+
+    expandLimits(x, y, x + w - 1, y1);
 }
 
 // ############################################################################################
 
-uint8_t LightLCD::drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8_t transparentBg, uint8_t size) {
+uint8_t LightLCD::drawChar(int16_t x, int16_t y, uint8_t c, uint8_t color, uint8_t transparentBg, uint8_t size) {
     uint8_t len;
     uint8_t line;
     
     int8_t col;
     
     len = pgm_read_byte(font_width + c);
-    
-    
-    if (x >= width()  || y >= height() ||
-       (x + len * size - 1) < 0          ||
-       (y + 8   * size - 1) < 0 )
-        return 0;
+
+    x += origin_x;
+    y += origin_y;
+
+    // Nothing to draw, but the text still moves on
+    if (x > clip_x1 || x + (len + 1) * size <= clip_x0 ||
+        y > clip_y1 || y + 7   * size       <= clip_y0)
+        return (len + 1) * size;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    if (buffer != NULL && size <= 4) {
+        blitChar(x, y, c, len, color, transparentBg, size);
+        return (len + 1) * size;
+    }
 
     for (int8_t i = 0; i < len + 1; i++ ) {
         if(i == len)
@@ -134,9 +1413,9 @@ uint8_t LightLCD::drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8
             // col = -1 means do not draw.
             if(col != -1) {
                 if (size == 1) // default size
-                    drawPixel(x + i, y + j - 1, col);
+                    plot(x + i, y + j - 1, col);
                 else  // big size
-                    fillRect(x + i*size, y + (j - 1)*size, size, size, col);
+                    fillArea(x + i*size, y + (j - 1)*size, size, size, col);
             }
             
         }
@@ -145,13 +1424,69 @@ uint8_t LightLCD::drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8
     return (len + 1) * size;
 }
 
+/* Fast path of drawChar: each font column is stretched to 7 * size rows
+ * and merged into the pages it overlaps, a byte at a time.
+ */
+void LightLCD::blitChar(int16_t x, int16_t y, uint8_t c, uint8_t len, uint8_t color, uint8_t transparentBg, uint8_t size) {
+    uint8_t shift = y & 7;
+    uint8_t count = (shift + 7 * size + 7) / 8;
+
+    // Pages touched by the glyph, NULL when clipped or not in RAM, and the
+    // rows the clip rectangle leaves in each
+    uint8_t *pages[5];
+    uint8_t  clip[5];
+
+    for (uint8_t k = 0; k < count; k++)
+        pages[k] = clipPage((y >> 3) + k, clip[k]);
+
+    // Visible part of the glyph
+    int16_t x0 = x > clip_x0 ? x : clip_x0;
+    int16_t x1 = x + (len + 1) * size - 1;
+    int16_t y0 = y > clip_y0 ? y : clip_y0;
+    int16_t y1 = y + 7 * size - 1;
+
+    if (x1 > clip_x1) x1 = clip_x1;
+    if (y1 > clip_y1) y1 = clip_y1;
+
+    // The rows the glyph covers when the background is drawn
+    uint32_t area = stretchBits(0x7F, size);
+    int16_t  col  = x;
+
+    for (uint8_t i = 0; i <= len && col <= x1; i++) {
+        uint8_t line = i == len ? 0 : pgm_read_byte(font + 5*c + i);
+
+        // Font rows start from bit 1
+        uint32_t bits = stretchBits(line >> 1, size);
+        uint32_t mask = transparentBg ? bits : area;
+
+        for (uint8_t r = 0; r < size && col <= x1; r++, col++) {
+            if (col < x0)
+                continue;
+
+            for (uint8_t k = 0; k < count; k++) {
+                uint8_t b = k ? bits >> (8 * k - shift) : bits << shift;
+                uint8_t m = k ? mask >> (8 * k - shift) : mask << shift;
+
+                m &= clip[k];
+
+                if (m)
+                    mergeBits(pages[k] + col, b, m, color);
+            }
+        }
+    }
+
+    LIGHTLCD_STAT(stats.pixels += (x1 - x0 + 1) * (y1 - y0 + 1));
+
+    expandLimits(x0, y0, x1, y1);
+}
+
 /* Draw XBitMap Files (*.xbm), exported from GIMP,
  * Uses PROGMEM array directly from *.xbm as this:
  * 
  *  const static uint8_t image[] PROGMEM = { ... };
  * 
 */
-void LightLCD::drawXBitmap(uint8_t x, uint8_t y,
+void LightLCD::drawXBitmap(int16_t x, int16_t y,
                  const uint8_t *bitmap, uint8_t width, uint8_t height,
                  uint8_t color, uint8_t transparentBg) {
     // NOTE: being 8bit long, max width & height is 255.
@@ -162,6 +1497,16 @@ void LightLCD::drawXBitmap(uint8_t x, uint8_t y,
     uint8_t bit, block = 0;
     int8_t  final_color;
 
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x += origin_x;
+    y += origin_y;
+
+    if (buffer != NULL) {
+        blitXBitmap(x, y, bitmap, width, height, color, transparentBg);
+        return;
+    }
+
     for (j = 0; j < height; j++) {
         for (i = 0; i < width; i++ ) {
             // The current pixel in the block.
@@ -177,31 +1522,337 @@ void LightLCD::drawXBitmap(uint8_t x, uint8_t y,
                         : !color;                    // Background pixel, draw it
 
             if(final_color != -1)
-                drawPixel(x + i, y + j, final_color);
+                plot(x + i, y + j, final_color);
+        }
+    }
+}
+
+/* Transpose an 8x8 block of XBM rows (bit i of rows[j] is pixel i,j) into
+ * page columns (bit j of cols[i] is pixel i,j), Hacker's Delight style.
+ */
+static void transposeBlock(const uint8_t *rows, uint8_t *cols) {
+    uint32_t x = (uint32_t)rows[7] << 24 | (uint32_t)rows[6] << 16 | rows[5] << 8 | rows[4];
+    uint32_t y = (uint32_t)rows[3] << 24 | (uint32_t)rows[2] << 16 | rows[1] << 8 | rows[0];
+    uint32_t t;
+
+    t = (x ^ (x >>  7)) & 0x00AA00AA;  x = x ^ t ^ (t <<  7);
+    t = (y ^ (y >>  7)) & 0x00AA00AA;  y = y ^ t ^ (t <<  7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;  x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;  y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    cols[7] = x >> 24; cols[6] = x >> 16; cols[5] = x >> 8; cols[4] = x;
+    cols[3] = y >> 24; cols[2] = y >> 16; cols[1] = y >> 8; cols[0] = y;
+}
+
+/* Fast path of drawXBitmap: 8x8 blocks are read from flash, turned into
+ * page columns and merged into the (up to) two pages under them.
+ * Only the blocks with visible pixels are read.
+ */
+void LightLCD::blitXBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg) {
+    int16_t x0 = x > clip_x0 ? x : clip_x0;
+    int16_t y0 = y > clip_y0 ? y : clip_y0;
+    int16_t x1 = x + w - 1 < clip_x1 ? x + w - 1 : clip_x1;
+    int16_t y1 = y + h - 1 < clip_y1 ? y + h - 1 : clip_y1;
+
+    if (w == 0 || h == 0 || x0 > x1 || y0 > y1)
+        return;
+
+    uint8_t blocksPerRow = (w + 7) / 8;
+    uint8_t shift = y & 7;
+
+    uint8_t rows[8], cols[8];
+
+    for (uint16_t by = (y0 - y) & ~7; by <= y1 - y; by += 8) {
+        // Page under the top of the block, and the one below if not aligned
+        uint8_t  top_clip, bot_clip;
+        uint8_t *top = clipPage((y + by) >> 3,     top_clip);
+        uint8_t *bot = clipPage(((y + by) >> 3) + 1, bot_clip);
+
+        // Rows of this block inside the bitmap
+        uint8_t area = h - by >= 8 ? 0xFF : 0xFF >> (8 - (h - by));
+
+        for (uint8_t bx = (x0 - x) / 8; bx <= (x1 - x) / 8; bx++) {
+            for (uint8_t j = 0; j < 8; j++)
+                rows[j] = by + j < h ? pgm_read_byte(bitmap + (by + j) * blocksPerRow + bx) : 0;
+
+            transposeBlock(rows, cols);
+
+            for (uint8_t i = 0; i < 8; i++) {
+                int16_t col = x + bx * 8 + i;
+
+                if (col < x0)
+                    continue;
+
+                if (col > x1)
+                    break;
+
+                uint8_t mask = transparentBg ? cols[i] : area;
+
+                if (top)
+                    mergeBits(top + col, cols[i] << shift, (mask << shift) & top_clip, color);
+
+                if (bot && shift)
+                    mergeBits(bot + col, cols[i] >> (8 - shift), (mask >> (8 - shift)) & bot_clip, color);
+            }
+        }
+    }
+
+    LIGHTLCD_STAT(stats.pixels += (uint16_t)(x1 - x0 + 1) * (y1 - y0 + 1));
+
+    expandLimits(x0, y0, x1, y1);
+}
+
+void LightLCD::drawPageBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg) {
+    LIGHTLCD_STAT(stats.primitives++);
+
+    blitPages(x + origin_x, y + origin_y, bitmap, NULL, w, h, color, transparentBg);
+}
+
+void LightLCD::drawPageBitmap(int16_t x, int16_t y, const uint8_t *bitmap, const uint8_t *mask, uint8_t w, uint8_t h) {
+    LIGHTLCD_STAT(stats.primitives++);
+
+    blitPages(x + origin_x, y + origin_y, bitmap, mask, w, h, BLACK, false);
+}
+
+/* Page bitmaps need no transposing: on a page-aligned y an opaque one is
+ * copied straight from flash, otherwise each byte is split over two pages.
+ */
+void LightLCD::blitPages(int16_t x, int16_t y, const uint8_t *bitmap, const uint8_t *mask, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg) {
+    int16_t x0 = x > clip_x0 ? x : clip_x0;
+    int16_t y0 = y > clip_y0 ? y : clip_y0;
+    int16_t x1 = x + w - 1 < clip_x1 ? x + w - 1 : clip_x1;
+    int16_t y1 = y + h - 1 < clip_y1 ? y + h - 1 : clip_y1;
+
+    if (w == 0 || h == 0 || x0 > x1 || y0 > y1)
+        return;
+
+    if (buffer == NULL) {
+        for (uint8_t j = y0 - y; j <= y1 - y; j++)
+            for (uint8_t i = x0 - x; i <= x1 - x; i++) {
+                uint8_t bit  = 1 << (j % 8);
+                uint8_t fg   = pgm_read_byte(bitmap + (j / 8) * w + i) & bit;
+                uint8_t draw = mask ? pgm_read_byte(mask + (j / 8) * w + i) & bit : fg || !transparentBg;
+
+                if (draw)
+                    putPixel(x + i, y + j, fg ? color : !color);
+            }
+
+        return;
+    }
+
+    uint8_t cols  = x1 - x0 + 1;
+    uint8_t shift = y & 7;
+
+    for (uint8_t bp = (y0 - y) / 8; bp <= (y1 - y) / 8; bp++) {
+        uint8_t  top_clip, bot_clip;
+        uint8_t *top = clipPage((y >> 3) + bp,     top_clip);
+        uint8_t *bot = clipPage((y >> 3) + bp + 1, bot_clip);
+
+        // Rows of this page inside the bitmap
+        uint8_t area = h - bp * 8 >= 8 ? 0xFF : 0xFF >> (8 - (h - bp * 8));
+
+        const uint8_t *src = bitmap + bp * w + (x0 - x);
+        const uint8_t *msk = mask ? mask + bp * w + (x0 - x) : NULL;
+
+        if (top && shift == 0 && area == 0xFF && top_clip == 0xFF && msk == NULL && !transparentBg && color && raster_op == ROP_COPY) {
+            memcpy_P(top + x0, src, cols);
+            continue;
+        }
+
+        for (uint8_t i = 0; i < cols; i++) {
+            uint8_t b = pgm_read_byte(src + i);
+            uint8_t m = msk ? pgm_read_byte(msk + i) & area
+                      : transparentBg ? b & area
+                      : area;
+
+            if (top)
+                mergeBits(top + x0 + i, b << shift, (m << shift) & top_clip, color);
+
+            if (bot && shift)
+                mergeBits(bot + x0 + i, b >> (8 - shift), (m >> (8 - shift)) & bot_clip, color);
+        }
+    }
+
+    LIGHTLCD_STAT(stats.pixels += (uint16_t)cols * (y1 - y0 + 1));
+
+    expandLimits(x0, y0, x1, y1);
+}
+
+void LightLCD::drawRLEBitmap(int16_t x, int16_t y, const uint8_t *data, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg) {
+    if (w == 0 || h == 0)
+        return;
+
+    LIGHTLCD_STAT(stats.primitives++);
+
+    x += origin_x;
+    y += origin_y;
+
+    int16_t x0 = x > clip_x0 ? x : clip_x0;
+    int16_t y0 = y > clip_y0 ? y : clip_y0;
+    int16_t x1 = x + w - 1 < clip_x1 ? x + w - 1 : clip_x1;
+    int16_t y1 = y + h - 1 < clip_y1 ? y + h - 1 : clip_y1;
+
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    uint8_t shift = y & 7;
+
+    // The stream can't be skipped: decode up to the last visible page,
+    // and only write the visible columns
+    uint8_t pages = (y1 - y) / 8 + 1;
+    uint8_t col0  = x0 - x;
+    uint8_t col1  = x1 - x;
+
+    // Output position in the bitmap, and what's under its current page
+    uint8_t  bp = 0, col = 0;
+    uint8_t *top = NULL, *bot = NULL;
+    uint8_t  top_clip = 0, bot_clip = 0;
+    uint8_t  area = 0;
+
+    while (bp < pages) {
+        uint8_t ctrl = pgm_read_byte(data++);
+        uint8_t n    = (ctrl & 0x7F) + 1;
+        uint8_t b    = 0;
+
+        if (ctrl & 0x80)
+            b = pgm_read_byte(data++);
+
+        // Runs can go on in the next page
+        for (; n > 0 && bp < pages; n--) {
+            if (!(ctrl & 0x80))
+                b = pgm_read_byte(data++);
+
+            if (col == 0) {
+                top  = clipPage((y >> 3) + bp,     top_clip);
+                bot  = clipPage((y >> 3) + bp + 1, bot_clip);
+                area = h - bp * 8 >= 8 ? 0xFF : 0xFF >> (8 - (h - bp * 8));
+            }
+
+            if (col >= col0 && col <= col1) {
+                uint8_t m = transparentBg ? b & area : area;
+
+                if (top)
+                    mergeBits(top + x + col, b << shift, (m << shift) & top_clip, color);
+
+                if (bot && shift)
+                    mergeBits(bot + x + col, b >> (8 - shift), (m >> (8 - shift)) & bot_clip, color);
+
+                if (buffer == NULL)
+                    for (uint8_t j = 0; j < 8; j++)
+                        if (m & (1 << j))
+                            plot(x + col, y + bp * 8 + j, b & (1 << j) ? color : !color);
+            }
+
+            if (++col == w) {
+                col = 0;
+                bp++;
+            }
         }
     }
+
+    if (buffer == NULL)
+        return;
+
+    LIGHTLCD_STAT(stats.pixels += (uint16_t)(x1 - x0 + 1) * (y1 - y0 + 1));
+
+    expandLimits(x0, y0, x1, y1);
 }
 
 size_t LightLCD::write(uint8_t c) {
     if (c == '\n') {
-        cursor_y += text_prop.size * 8;
-        cursor_x = 0;
+        newLine();
     } else if (c != '\r')  {
         uint8_t c_width = drawChar(cursor_x, cursor_y, c, text_prop.color, text_prop.transparent, text_prop.size);
         
         cursor_x += c_width;
         
-        if (cursor_x >= width()) {
-            cursor_y += text_prop.size * 8;
-            cursor_x = 0;
-        }
+        if (cursor_x >= width())
+            newLine();
     }
 
     return 1;
 }
 
+void LightLCD::newLine() {
+    uint8_t line = text_prop.size * 8;
+
+    cursor_y += line;
+    cursor_x = 0;
+
+    // Keep the new line on screen, moving the old ones up
+    if (text_scroll && cursor_y + line > height()) {
+        scrollUp(cursor_y + line - height());
+        cursor_y = height() - line;
+    }
+}
+
+void LightLCD::scrollUp(uint8_t rows) {
+    uint8_t lcd_w = width();
+    uint8_t lcd_h = height();
+    uint8_t pages = lcd_h / 8;
+
+    if (buffer == NULL || strip_pages < pages || rows == 0)
+        return;
+
+    if (rows > lcd_h)
+        rows = lcd_h;
+
+    shiftUp(buffer, lcd_w, pages, rows);
+
+    if (rows % 8 == 0 && scrollPanel(rows)) {
+        uint8_t skip = rows / 8;
+
+        // The panel already shows the old content moved up, so does the
+        // shadow copy of it
+        if (shadow) {
+            shiftUp(shadow, lcd_w, pages, rows);
+            shadow_stale >>= skip;
+        }
+
+        // Changes not sent yet moved up with the content
+        for (uint8_t p = 0; p + skip < pages; p++)
+            dirty[p] = dirty[p + skip];
+
+        // What scrolled in is whatever the panel had on top
+        invalidatePages(pages - skip, pages - 1);
+    } else {
+        resetLimits(true);
+    }
+}
+
+// Move a w x pages buffer up by rows, filling the bottom with zeros
+void LightLCD::shiftUp(uint8_t *buf, uint8_t w, uint8_t pages, uint8_t rows) {
+    uint8_t skip = rows / 8;
+    uint8_t bits = rows % 8;
+
+    for (uint8_t p = 0; p < pages; p++) {
+        uint8_t *dst = buf + p * w;
+
+        if (p + skip >= pages) {
+            memset(dst, 0, w);
+            continue;
+        }
+
+        uint8_t *src  = buf + (p + skip) * w;
+        uint8_t *next = p + skip + 1 < pages ? src + w : NULL;
+
+        if (bits == 0) {
+            memmove(dst, src, w);
+            continue;
+        }
+
+        // Rows from the page below enter from the bottom of the byte
+        for (uint8_t x = 0; x < w; x++)
+            dst[x] = src[x] >> bits | (next ? next[x] << (8 - bits) : 0);
+    }
+}
+
 uint8_t LightLCD::getCharWidth(char c) {
-    return c > 127 ? 0 : (pgm_read_byte(font_width + c) * text_prop.size);
+    return (uint8_t)c > 127 ? 0 : (pgm_read_byte(font_width + (uint8_t)c) * text_prop.size);
 }
 
 uint8_t LightLCD::getStringWidth(const char* str) {
@@ -243,7 +1894,7 @@ uint8_t LightLCD::getCursorX() { return cursor_x; }
 uint8_t LightLCD::getCursorY() { return cursor_y; }
 
 void LightLCD::setCursor(uint8_t x, uint8_t y) {
-    if ((x < 0) || (x >= width()) || (y < 0) || (y >= height()))
+    if ((x >= width()) || (y >= height()))
         return;
 
     cursor_x = x;
@@ -258,6 +1909,11 @@ void LightLCD::setTextColor(uint8_t color, uint8_t transparentBg) {
     //bitWrite(text_prop, 0, color);
     text_prop.color = color;
 }
+
+void LightLCD::setTextScroll(uint8_t enable) {
+    text_scroll = enable;
+}
+
 void LightLCD::setTextSize(uint8_t size) {
     //text_prop = (text_prop & 0x03) | (size << 2);
     text_prop.size = size;
@@ -12,34 +12,231 @@
 #define _LIGHT_LCD_H
 
 #include "Arduino.h"
+#include "LightLCDConfig.h"
 
 #define BLACK 1
 #define WHITE 0
 
-struct Limits {
-    uint8_t x0, y0;
-    uint8_t x1, y1;
+// Raster ops, see setRasterOp()
+#define ROP_COPY   0
+#define ROP_SET    1
+#define ROP_CLEAR  2
+#define ROP_XOR    3
+#define ROP_INVERT 4
+
+// Dirty columns of one 8-rows page, both ends included.
+// x0 > x1 means the page has nothing to send.
+struct PageSpan {
+    uint8_t x0, x1;
+};
+
+// Background bytes a w x h sprite needs to keep, wherever it's placed
+#define LIGHTSPRITE_UNDER(w, h) ((w) * (((h) + 14) / 8))
+
+/* A page bitmap (see LightLCD::drawPageBitmap()) composited over the
+ * framebuffer, with the background it covers kept in `under`.
+ * Set up by LightLCD::addSprite(), changed through LightLCD.
+ */
+struct LightSprite {
+    const uint8_t *bitmap;
+    const uint8_t *mask;     // 1 where the sprite is opaque, NULL for all
+    uint8_t *under;          // LIGHTSPRITE_UNDER(w, h) bytes
+    uint8_t  w, h;
+    int16_t  x, y;           // Screen coordinates
+    uint8_t  visible;
+
+    // Where it is on the framebuffer, if shown
+    int16_t  shown_x, shown_y;
+    uint8_t  shown;
+    uint8_t  changed;
+
+    LightSprite *next;       // The one above
+};
+
+/* A strip chart: a trace scrolling left in a rectangle of the framebuffer,
+ * a column per samples_per_column samples. Set up by LightLCD::setupChart().
+ */
+struct LightChart {
+    uint8_t x, y, w, h;          // Screen rectangle
+    int16_t lo, hi;              // Values at the bottom and top rows
+    uint8_t samples_per_column;
+    uint8_t filled;              // Fill the columns down to the bottom
+
+    // Samples gathered for the next column, their range
+    uint8_t count;
+    int16_t min, max;
+
+    uint8_t last;                // Row the trace left off, 0xFF if none
 };
 
+#ifdef LIGHTLCD_STATS
+// Totals since the last resetStats(), divide by updates for per-frame values
+struct LightLCDStats {
+    unsigned long pixels;        // Pixels covered by drawing
+    unsigned long primitives;    // Drawing calls, each shape counted once
+    unsigned long updates;       // Flushes started
+    unsigned long dirtyBytes;    // Dirty bytes found by the flushes
+    unsigned long busBytes;      // Bytes sent to the panel, commands included
+    unsigned long transactions;  // SPI selections or I2C transmissions
+    unsigned long updateMicros;  // Time spent flushing
+};
+#endif
+
+template <uint8_t N> class LightCanvas;
+
 class LightLCD : public Print {
+    // Sets its panels' origin and clip for each primitive
+    template <uint8_t N> friend class LightCanvas;
+
     public:
-        LightLCD();
+        LightLCD(uint8_t *buffer = NULL, PageSpan *dirty = NULL, uint8_t stripPages = 0xFF);
 
         virtual void    begin() = 0;
 
         virtual void    clear() = 0;
-        virtual void    update() = 0;
+        virtual void    update();
 
-        virtual void    drawPixel(uint8_t x, uint8_t y, uint8_t color) = 0;
+        /* Incremental update: beginUpdate() starts a flush of the dirty
+         * pages, then each pollUpdate() sends at most maxBytes of them (or
+         * keeps sending for maxMicros) and returns true once done.
+         * Drawing is allowed in between: pages not reached yet are sent with
+         * their new content, the others stay dirty for the next update.
+         */
+        virtual void    beginUpdate();
+        virtual bool    pollUpdate(uint16_t maxBytes);
+        bool    pollUpdateFor(uint16_t maxMicros);
+
+        /* Page-strip rendering, for drivers built with LIGHTLCD_STRIP_PAGES:
+         * only a strip of pages is kept in RAM, so the whole frame is drawn
+         * once per strip.
+         *
+         *  lcd.firstPage();
+         *  do {
+         *      lcd.drawSomething(...);
+         *  } while (lcd.nextPage());
+         *
+         * Each pass starts with an empty strip and the cursor at 0,0.
+         * With a full framebuffer there's a single pass, sent by update().
+         */
+        void    firstPage();
+        bool    nextPage();
+        void    drawPages(void (*draw)(LightLCD &lcd));
+
+        /* Clipping and viewport: coordinates are taken relative to the
+         * origin, and each primitive is cut to the clip rectangle once,
+         * before drawing. Parts off the screen (negative too) are clipped.
+         *
+         * setViewport() moves the origin to x,y and clips to the w x h area
+         * there, so a widget can draw itself from 0,0 wherever it's placed.
+         * setClipRect() takes coordinates relative to the current origin.
+         */
+        void    setClipRect(int16_t x, int16_t y, uint8_t w, uint8_t h);
+        void    setViewport(int16_t x, int16_t y, uint8_t w, uint8_t h);
+        void    setOrigin(int16_t x, int16_t y);
+        void    resetClip();
+
+        /* How drawn pixels are combined with the framebuffer:
+         *
+         * ROP_COPY   - pixels take the color they're drawn with (default)
+         * ROP_SET    - pixels drawn BLACK are set, the others left alone
+         * ROP_CLEAR  - pixels drawn BLACK are cleared (AND-NOT)
+         * ROP_XOR    - pixels drawn BLACK are toggled
+         * ROP_INVERT - every pixel drawn is toggled, whatever its color
+         *
+         * Drawing the same thing twice with XOR or INVERT restores what was
+         * under it. Needs a framebuffer: without one, pixels are copied.
+         */
+        void    setRasterOp(uint8_t op);
+        uint8_t getRasterOp();
 
-        void    drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color);
-        void    drawVLine(uint8_t x, uint8_t y, uint8_t h, uint8_t color);
-        void    drawHLine(uint8_t x, uint8_t y, uint8_t w, uint8_t color);
-        void    drawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
-        void    fillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
+        void    drawPixel(int16_t x, int16_t y, uint8_t color);
 
-        uint8_t drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color = 1, uint8_t transparentBg = 1, uint8_t size = 1);
-        void    drawXBitmap(uint8_t x, uint8_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, uint8_t color, uint8_t transparentBg=1);
+        // Set a pixel already clipped, in screen coordinates: what drivers
+        // implement (and all the primitives end up in without a framebuffer).
+        // Drivers written for the old virtual drawPixel(), see LightLCDLegacy.
+        virtual void    putPixel(uint8_t x, uint8_t y, uint8_t color) = 0;
+
+        void    drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color);
+
+        // Lines joining count points, given as x,y pairs or (for plots) as
+        // one y per point, step columns apart from x. Shared ends are drawn
+        // once.
+        void    drawPolyline(const int16_t *points, uint8_t count, uint8_t color);
+        void    drawPolyline(int16_t x, uint8_t step, const uint8_t *ys, uint8_t count, uint8_t color);
+        void    drawVLine(int16_t x, int16_t y, uint8_t h, uint8_t color);
+        void    drawHLine(int16_t x, int16_t y, uint8_t w, uint8_t color);
+        void    drawRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color);
+        void    fillRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color);
+
+        /* Shapes are filled with vertical spans, each column once, which go
+         * through fillRect() and so touch a byte per 8 rows.
+         * Parts going off screen are clipped.
+         */
+        void    drawCircle(int16_t x0, int16_t y0, uint8_t r, uint8_t color);
+        void    fillCircle(int16_t x0, int16_t y0, uint8_t r, uint8_t color);
+        void    drawRoundRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color);
+        void    fillRoundRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color);
+        void    drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color);
+        void    fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color);
+
+        uint8_t drawChar(int16_t x, int16_t y, uint8_t c, uint8_t color = 1, uint8_t transparentBg = 1, uint8_t size = 1);
+        void    drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, uint8_t color, uint8_t transparentBg=1);
+
+        /* Bitmaps in the panels' own layout (see extras/bmp2page.py): w bytes
+         * for each 8-rows page, LSB on top. The masked version draws the
+         * bitmap where mask has a 1 and leaves the rest untouched.
+         */
+        void    drawPageBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg=1);
+        void    drawPageBitmap(int16_t x, int16_t y, const uint8_t *bitmap, const uint8_t *mask, uint8_t w, uint8_t h);
+
+        /* Run-length compressed page bitmaps (bmp2page.py --rle), decoded
+         * straight into the framebuffer. Each control byte is followed by
+         * either (c & 0x7F) + 1 copies of one byte (bit 7 set) or by
+         * c + 1 literal bytes, in drawPageBitmap() order.
+         */
+        void    drawRLEBitmap(int16_t x, int16_t y, const uint8_t *data, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg=1);
+
+        /* Sprites over a retained background:
+         *
+         *  LightSprite ship;
+         *  uint8_t shipUnder[LIGHTSPRITE_UNDER(16, 12)];
+         *
+         *  lcd.addSprite(ship, shipBitmap, shipMask, 16, 12, shipUnder);
+         *  lcd.moveSprite(ship, x, y);
+         *  lcd.update();
+         *
+         * Changes are composited by drawSprites(), which update() calls
+         * first: a sprite that moved gets the background back in its old
+         * rectangle and is drawn in the new one, a byte per 8 rows, and
+         * only those two rectangles become dirty. Sprites are stacked in
+         * the order they're added, the last one on top.
+         *
+         * To draw on the background call hideSprites() first, they come
+         * back at the next update(). clear() drops them from the framebuffer
+         * the same way. Needs a full framebuffer, not page-strip mode.
+         */
+        void    addSprite(LightSprite &s, const uint8_t *bitmap, const uint8_t *mask, uint8_t w, uint8_t h, uint8_t *under);
+        void    removeSprite(LightSprite &s);
+        void    moveSprite(LightSprite &s, int16_t x, int16_t y);
+        void    setSpriteImage(LightSprite &s, const uint8_t *bitmap, const uint8_t *mask);
+        void    showSprite(LightSprite &s, uint8_t visible);
+        void    drawSprites();
+        void    hideSprites();
+
+        /* Strip chart: each new column moves the chart's rectangle left in
+         * the framebuffer (a memmove per page) and only that column is
+         * drawn, so a sample costs the height of the chart, not its width.
+         * With several samples per column, it shows their min..max range.
+         * Only the rectangle becomes dirty.
+         *
+         * The rectangle is taken relative to the origin and cut to the clip
+         * rectangle when set up, then cleared. The trace is BLACK.
+         * Needs the chart's pages in RAM (not page-strip mode).
+         */
+        void    setupChart(LightChart &c, int16_t x, int16_t y, uint8_t w, uint8_t h, int16_t lo, int16_t hi, uint8_t samplesPerColumn = 1);
+        void    addChartSample(LightChart &c, int16_t value);
+        void    addChartSamples(LightChart &c, const int16_t *values, uint8_t count);
+        void    clearChart(LightChart &c);
 
         uint8_t getCursorX();
         uint8_t getCursorY();
@@ -48,6 +245,14 @@ class LightLCD : public Print {
         void    setTextColor(uint8_t color, uint8_t transparentBg = 0xff);
         void    setTextSize(uint8_t size);
 
+        // Console mode: when text reaches the bottom, the screen scrolls up
+        // instead of the text being lost.
+        void    setTextScroll(uint8_t enable);
+
+        // Shift the whole framebuffer up by rows, the rows at the bottom are
+        // cleared and marked dirty. Not available in page-strip mode.
+        void    scrollUp(uint8_t rows);
+
         uint8_t getCharWidth(char c);
         uint8_t getStringWidth(const char* str);
         uint8_t getStringWidth(const __FlashStringHelper* str);
@@ -56,11 +261,62 @@ class LightLCD : public Print {
 
         virtual int width() = 0;
         virtual int height() = 0;
+
+        // Keep a copy of the last frame sent in `shadow` (same size as the
+        // framebuffer) and only send bytes that differ from it.
+        // Changed bytes less than `granularity` columns apart are sent in the
+        // same run, since every run costs its own addressing. NULL disables.
+        void    setShadowBuffer(uint8_t *shadow, uint8_t granularity = 4);
+
+        // Bytes found unchanged (and not sent) since the last reset.
+        unsigned long getSkippedBytes();
+        void    resetSkippedBytes();
+
+#ifdef LIGHTLCD_STATS
+        const LightLCDStats &getStats() { return stats; }
+        void    resetStats();
+        void    printStats(Print &out);
+#endif
         
     protected:
-        Limits limits;
+        // Page-major framebuffer owned by the driver: one byte per column for
+        // each 8-rows page, LSB on top. NULL if the driver has no buffer, in
+        // which case primitives fall back to putPixel().
+        uint8_t *buffer;
+        // One dirty span per page, owned by the driver too.
+        PageSpan *dirty;
+
+        // Pages held in buffer: strip_pages of them, starting from strip_first
+        uint8_t  strip_first;
+        uint8_t  strip_pages;
+
+        uint8_t *shadow;
+        uint8_t  diff_gap;
+        unsigned long skipped;
+
+        // One bit per page whose shadow copy can't be trusted: its dirty
+        // columns are sent without comparing, until the page is sent whole
+        uint32_t shadow_stale;
+
+        // Next page to be sent by pollUpdate()
+        uint8_t  flush_page;
+
+#ifdef LIGHTLCD_STATS
+        LightLCDStats stats;
+#endif
+
+        // Added to all coordinates, then cut to clip_x0..x1, clip_y0..y1
+        // (screen coordinates, both ends included, x0 > x1 if empty)
+        int16_t origin_x, origin_y;
+        uint8_t clip_x0, clip_y0, clip_x1, clip_y1;
+
+        uint8_t raster_op;
+
+        // Bottom of the sprite stack
+        LightSprite *sprites;
 
         uint8_t cursor_x, cursor_y;
+        uint8_t text_scroll;
         //uint8_t text_prop;
 
         struct TextProp {
@@ -69,8 +325,165 @@ class LightLCD : public Print {
             uint8_t size    : 6;
         } text_prop;
 
+        // Start of the given page in buffer, NULL if it's not in RAM
+        uint8_t *pageBuffer(uint8_t page) {
+            page -= strip_first;
+            return page < strip_pages ? buffer + page * width() : NULL;
+        }
+
+        // Cut x,y,w,h (screen coordinates) to the clip rectangle, false if
+        // nothing is left
+        bool clipArea(int16_t &x, int16_t &y, int16_t &w, int16_t &h) {
+            if (x < clip_x0) { w -= clip_x0 - x; x = clip_x0; }
+            if (y < clip_y0) { h -= clip_y0 - y; y = clip_y0; }
+
+            if (x + w > clip_x1 + 1) w = clip_x1 + 1 - x;
+            if (y + h > clip_y1 + 1) h = clip_y1 + 1 - y;
+
+            return w > 0 && h > 0;
+        }
+
+        // Page p if the clip rectangle reaches it and it's in RAM, with the
+        // rows it lets through in mask
+        uint8_t *clipPage(int16_t p, uint8_t &mask) {
+            if (p < clip_y0 / 8 || p > clip_y1 / 8 || buffer == NULL) {
+                mask = 0;
+                return NULL;
+            }
+
+            uint8_t *ptr = pageBuffer(p);
+
+            mask = ptr ? pageMask(p, clip_y0, clip_y1) : 0;
+            return ptr;
+        }
+
+        // Bits of page p covered by rows y0..y1
+        static uint8_t pageMask(uint8_t p, uint8_t y0, uint8_t y1) {
+            uint8_t mask = 0xFF;
+
+            if (p == y0 / 8) mask &= 0xFF << (y0 % 8);
+            if (p == y1 / 8) mask &= 0xFF >> (7 - y1 % 8);
+
+            return mask;
+        }
+
+        // Write the pixels in mask, value holds their colors (only in mask)
+        void writeBits(uint8_t *ptr, uint8_t value, uint8_t mask) {
+            switch (raster_op) {
+                case ROP_SET:    *ptr |= value;  break;
+                case ROP_CLEAR:  *ptr &= ~value; break;
+                case ROP_XOR:    *ptr ^= value;  break;
+                case ROP_INVERT: *ptr ^= mask;   break;
+                default:         *ptr = (*ptr & ~mask) | value;
+            }
+        }
+
+        // Draw the mask bits of w consecutive columns of a page with color
+        void fillColumns(uint8_t *ptr, uint8_t w, uint8_t mask, uint8_t color) {
+            if (raster_op != ROP_COPY)
+                for (uint8_t i = 0; i < w; i++) writeBits(ptr + i, color ? mask : 0, mask);
+            else if (mask == 0xFF)
+                memset(ptr, color ? 0xFF : 0x00, w);
+            else if (color)
+                for (uint8_t i = 0; i < w; i++) ptr[i] |= mask;
+            else
+                for (uint8_t i = 0; i < w; i++) ptr[i] &= ~mask;
+        }
+
+        // Within mask, draw the pixels of bits with color and the others with !color
+        void mergeBits(uint8_t *ptr, uint8_t bits, uint8_t mask, uint8_t color) {
+            uint8_t fg = color ? bits : ~bits;
+
+            writeBits(ptr, fg & mask, mask);
+        }
+
+        // Blits take screen coordinates and clip themselves
+        void    blitPages(int16_t x, int16_t y, const uint8_t *bitmap, const uint8_t *mask, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg);
+        void    blitXBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color, uint8_t transparentBg);
+        void    blitChar(int16_t x, int16_t y, uint8_t c, uint8_t len, uint8_t color, uint8_t transparentBg, uint8_t size);
+
+        // Clipped pixel and rectangle, in screen coordinates
+        void plot(int16_t x, int16_t y, uint8_t color);
+        void fillArea(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
+        // Same, already inside the clip rectangle. w and h reach 256 on a
+        // wide canvas.
+        void fillSpan(uint8_t x, uint8_t y, uint16_t w, uint16_t h, uint8_t color);
+
+        // Bresenham walk of a line, after clipping: count + 1 pixels from
+        // x,y along x (along y if steep), with err as left by the steps
+        // skipped. Coordinates are kept 15 bits apart.
+        struct LineWalk {
+            uint8_t  x, y;
+            uint16_t count;
+            uint8_t  steep;
+            int8_t   ystep;
+            int16_t  dx, dy, err;
+        };
+
+        // Clips x0,y0 - x1,y1 (screen coordinates), false if nothing is left.
+        // Without the end point, joined lines draw each corner once.
+        bool clipLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, LineWalk &walk, uint8_t withEnd = true);
+        void walkLine(LineWalk &walk, uint8_t color);
+        void xorTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color);
+
+        // Arcs of radius r without the points on the axes (screen
+        // coordinates): corners bits are
+        // 1 top-left, 2 top-right, 4 bottom-right, 8 bottom-left, centered on
+        // cx,cy with the right ones xgap and the bottom ones ygap further.
+        // fillArcs covers the columns right (1) and/or left (2) of cx, each
+        // stretched down by stretch rows.
+        void drawArcs(int16_t cx, int16_t cy, uint8_t r, uint8_t corners, int16_t xgap, int16_t ygap, uint8_t color);
+        void fillArcs(int16_t cx, int16_t cy, uint8_t r, uint8_t sides, int16_t stretch, uint8_t color);
+
+        // Sprites
+        void restoreSprites(LightSprite *s);
+        void copyUnder(LightSprite &s, uint8_t save);
+        void dropSprites();
+
+        void drawChartColumn(LightChart &c, uint8_t x, int16_t lastValue);
+
+        // Move columns x..x+w-1 of rows y..y+h-1 (screen coordinates) left
+        // by cols, the ones left on the right are cleared
+        void shiftLeft(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t cols);
+
+        void newLine();
+        static void shiftUp(uint8_t *buf, uint8_t w, uint8_t pages, uint8_t rows);
+
+        // Called by scrollUp() for whole pages: return true if the driver moved
+        // what the panel shows by itself, so only the new rows have to be sent.
+        virtual uint8_t scrollPanel(uint8_t /* rows */) { return false; }
+
         void resetLimits(uint8_t whole);
         void expandLimits(uint8_t x, uint8_t y);
+        void expandLimits(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+
+        // The panel lost pages first..last (hardware scroll...): send them
+        // whole on the next update, shadow buffer or not.
+        void invalidatePages(uint8_t first, uint8_t last);
+
+        // Called by update() for every page with dirty columns x0..x1.
+        virtual void sendPage(uint8_t /* page */, uint8_t /* x0 */, uint8_t /* x1 */) {}
+
+        // Called around each group of sendPage() calls.
+        virtual void beginTransfer() {}
+        virtual void endTransfer() {}
+
+        void sendChanged(uint8_t page, uint8_t x0, uint8_t x1);
+};
+
+/* Base for drivers written before putPixel(), which implement the
+ * unclipped virtual drawPixel(uint8_t, uint8_t, uint8_t): deriving them
+ * from this instead of LightLCD is all they need. Through a
+ * LightLCD pointer or reference, drawPixel() is clipped and then reaches
+ * theirs; on the driver type it's still their own.
+ *
+ * New drivers implement putPixel().
+ */
+class LightLCDLegacy : public LightLCD {
+    public:
+        virtual void    drawPixel(uint8_t x, uint8_t y, uint8_t color) = 0;
+
+        void    putPixel(uint8_t x, uint8_t y, uint8_t color) { drawPixel(x, y, color); }
 };
 
 #endif
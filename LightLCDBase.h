@@ -0,0 +1,147 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _LIGHT_LCD_BASE_H
+#define _LIGHT_LCD_BASE_H
+
+#include "LightLCD.h"
+
+// Pages kept in RAM for an h rows panel: all of them, or LIGHTLCD_STRIP_PAGES
+// if defined before including the driver (see LightLCD::firstPage()).
+#if defined(LIGHTLCD_STRIP_PAGES)
+    #define LIGHTLCD_RAM_PAGES(h) (LIGHTLCD_STRIP_PAGES < (h) / 8 ? LIGHTLCD_STRIP_PAGES : (h) / 8)
+#else
+    #define LIGHTLCD_RAM_PAGES(h) ((h) / 8)
+#endif
+
+/* Common base for page-major drivers, with the panel size known at compile
+ * time. It owns the framebuffer and the dirty spans, and provides inline
+ * versions of putPixel and of the rectangle primitives: when called on the
+ * driver type (not through a LightLCD pointer or reference) they skip the
+ * vtable and fold the geometry into constants. Lines are drawn in runs by
+ * LightLCD::drawLine().
+ *
+ * Driver is the derived class (CRTP), so it can still replace putPixel.
+ */
+template <class Driver, uint8_t W, uint8_t H, uint8_t RAM_PAGES = LIGHTLCD_RAM_PAGES(H)>
+class LightLCDBase : public LightLCD {
+    public:
+        LightLCDBase() : LightLCD(framebuffer, spans, RAM_PAGES) {
+            resetClip();
+        }
+
+        void clear() {
+            memset(framebuffer, 0, sizeof(framebuffer));
+            resetLimits(true);
+            dropSprites();
+
+            cursor_y = cursor_x = 0;
+        }
+
+        void drawPixel(int16_t x, int16_t y, uint8_t color) {
+            x += origin_x;
+            y += origin_y;
+
+            if (x < clip_x0 || x > clip_x1 || y < clip_y0 || y > clip_y1)
+                return;
+
+            self()->Driver::putPixel(x, y, color);
+        }
+
+        // x,y are inside the clip rectangle, only the strip is checked
+        void putPixel(uint8_t x, uint8_t y, uint8_t color) {
+            // Page relative to the strip in RAM
+            uint8_t page = y / 8 - strip_first;
+
+            if (page >= RAM_PAGES)
+                return;
+
+            LIGHTLCD_STAT(stats.pixels++);
+
+            uint8_t *ptr = framebuffer + x + page * W;
+
+            if (raster_op != ROP_COPY)
+                writeBits(ptr, color ? _BV(y % 8) : 0, _BV(y % 8));
+            else if (color)
+                *ptr |= _BV(y % 8);
+            else
+                *ptr &= ~_BV(y % 8);
+
+            expandLimits(x, y);
+        }
+
+        void drawVLine(int16_t x, int16_t y, uint8_t h, uint8_t color) {
+            fillRect(x, y, 1, h, color);
+        }
+
+        void drawHLine(int16_t x, int16_t y, uint8_t w, uint8_t color) {
+            fillRect(x, y, w, 1, color);
+        }
+
+        // Corners go with the horizontal sides, so each pixel is drawn once
+        void drawRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color) {
+            if (w == 0 || h == 0)
+                return;
+
+            LIGHTLCD_STAT(stats.primitives++);
+
+            x += origin_x;
+            y += origin_y;
+
+            fillArea(x, y, w, 1, color);
+
+            if (h > 1)
+                fillArea(x, y+h-1, w, 1, color);
+
+            if (h > 2) {
+                fillArea(x, y+1, 1, h-2, color);
+
+                if (w > 1)
+                    fillArea(x+w-1, y+1, 1, h-2, color);
+            }
+        }
+
+        void fillRect(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t color) {
+            LIGHTLCD_STAT(stats.primitives++);
+
+            fillArea(x + origin_x, y + origin_y, w, h, color);
+        }
+
+        int width()  { return W; }
+        int height() { return H; }
+
+    protected:
+        // LightLCD::fillArea() with the geometry known: screen coordinates,
+        // clipped here
+        void fillArea(int16_t x, int16_t y, int16_t ww, int16_t hh, uint8_t color) {
+            if (!clipArea(x, y, ww, hh))
+                return;
+
+            LIGHTLCD_STAT(stats.pixels += ww * hh);
+
+            uint8_t y1 = y + hh - 1;
+
+            for (uint8_t p = y / 8; p <= y1 / 8; p++) {
+                uint8_t page = p - strip_first;
+
+                if (page < RAM_PAGES)
+                    fillColumns(framebuffer + page * W + x, ww, pageMask(p, y, y1), color);
+            }
+
+            expandLimits(x, y, x + ww - 1, y1);
+        }
+
+        uint8_t  framebuffer[W * RAM_PAGES];
+        PageSpan spans[H / 8];
+
+        Driver *self() { return static_cast<Driver*>(this); }
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _LIGHT_LCD_BUS_H
+#define _LIGHT_LCD_BUS_H
+
+#include "LightLCD.h"
+
+#ifdef LIGHTLCD_STATS
+    #define LIGHTBUS_STAT(x) if (stats) stats->x
+#else
+    #define LIGHTBUS_STAT(x)
+#endif
+
+/* How a driver talks to its controller: command bytes, and display data
+ * given a whole page span at a time, so each bus can batch it its own way.
+ *
+ * Writes are grouped between beginTransfer() and endTransfer() (chip
+ * select held, I2C transmissions...). Commands may be held back until
+ * flush(), data() or endTransfer().
+ *
+ * Implementations: LightSPIBus, LightSoftSPIBus, LightDMASPIBus
+ * (LightSPIBus.h), LightI2CBus (LightI2CBus.h), LightMockBus (below).
+ */
+class LightLCDBus {
+    public:
+        LightLCDBus() {
+            LIGHTLCD_STAT(stats = NULL);
+        }
+
+        virtual void begin() {}
+
+        virtual void beginTransfer() {}
+        virtual void endTransfer() { flush(); }
+
+        virtual void command(uint8_t cmd) = 0;
+        virtual void data(const uint8_t *data, uint8_t len) = 0;
+
+        // Send the commands held back, if any
+        virtual void flush() {}
+
+#ifdef LIGHTLCD_STATS
+        // Where bus bytes and transactions are counted, set by the driver
+        LightLCDStats *stats;
+#endif
+};
+
+// Entries in a LightMockBus log
+#define LIGHTBUS_BEGIN   'B'    // beginTransfer()
+#define LIGHTBUS_END     'E'    // endTransfer()
+#define LIGHTBUS_COMMAND 'C'    // Followed by the command byte
+#define LIGHTBUS_DATA    'D'    // Followed by the length and the bytes
+
+/* Records what a driver sends in a caller's buffer, for tests: drivers take
+ * it like any other bus.
+ *
+ *  uint8_t log[512];
+ *  LightMockBus bus(log, sizeof(log));
+ *  LightSSD1306 lcd(bus);
+ *
+ * Once the buffer is full the rest is not recorded, but still counted.
+ */
+class LightMockBus : public LightLCDBus {
+    public:
+        LightMockBus(uint8_t *log, uint16_t size) : log(log), size(size) {
+            reset();
+        }
+
+        void beginTransfer()      { record(LIGHTBUS_BEGIN); transfers++; }
+        void endTransfer()        { record(LIGHTBUS_END); }
+        void command(uint8_t cmd) { record(LIGHTBUS_COMMAND); record(cmd); commands++; }
+
+        void data(const uint8_t *data, uint8_t len) {
+            record(LIGHTBUS_DATA);
+            record(len);
+
+            for (uint8_t i = 0; i < len; i++)
+                record(data[i]);
+
+            dataBytes += len;
+        }
+
+        void reset() {
+            length    = 0;
+            overflow  = false;
+            transfers = 0;
+            commands  = 0;
+            dataBytes = 0;
+        }
+
+        uint8_t  *log;
+        uint16_t  size;
+        uint16_t  length;       // Bytes recorded in log
+        uint8_t   overflow;     // Some were left out
+
+        unsigned long transfers, commands, dataBytes;
+
+    protected:
+        void record(uint8_t b) {
+            if (length < size)
+                log[length++] = b;
+            else
+                overflow = true;
+        }
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _LIGHT_LCD_CONFIG_H
+#define _LIGHT_LCD_CONFIG_H
+
+/* Library wide options. These change LightLCD.cpp too, so they must be set
+ * here (or as compiler flags), not in the sketch.
+ */
+
+// Count pixels, primitives and bus traffic, see LightLCD::getStats().
+// Adds about 30 bytes of RAM per display and a few cycles per call.
+//#define LIGHTLCD_STATS
+
+#ifdef LIGHTLCD_STATS
+    #define LIGHTLCD_STAT(x) x
+#else
+    #define LIGHTLCD_STAT(x)
+#endif
+
+#endif
@@ -11,8 +11,8 @@
 #ifndef _LIGHT_PCD8544_H
 #define _LIGHT_PCD8544_H
 
-#include "LightLCD.h"
-#include <SPI.h>
+#include "LightLCDBase.h"
+#include "LightSPIBus.h"
 
 #define PCD8544
 
@@ -34,19 +34,23 @@
 #define PCD8544_SETBIAS 0x10
 #define PCD8544_SETVOP 0x80
 
-class LightPCD8544 : public LightLCD {
+/* On hardware SPI with the given D/C and CS pins, or on any LightLCDBus
+ * (LightSoftSPIBus for other pins...).
+ *
+ * The hardware SPI bus is a member, unused when another bus is given: it
+ * costs about 14 bytes of RAM on AVR either way.
+ */
+class LightPCD8544 : public LightLCDBase<LightPCD8544, 84, 48> {
     public:
-        LightPCD8544(uint8_t DC, uint8_t CS) : dc(DC), cs(CS) {}
+        LightPCD8544(uint8_t DC, uint8_t CS, SPISettings settings = SPISettings(4000000, MSBFIRST, SPI_MODE0))
+            : spi(DC, CS, settings), other_bus(NULL) {}
+
+        LightPCD8544(LightLCDBus &bus) : spi(0xFF, 0xFF), other_bus(&bus) {}
 
         void begin() {
-            // set pin directions
-            pinMode(dc, OUTPUT);
-            pinMode(cs, OUTPUT);
-            
-            //pinMode(SS, OUTPUT);
+            LIGHTLCD_STAT(bus().stats = &stats);
 
-            SPI.begin();
-            SPI.setClockDivider(SPI_CLOCK_DIV16);
+            bus().begin();
 
             // Enter extended instruction mode
             command(PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION );
@@ -66,92 +70,56 @@ class LightPCD8544 : public LightLCD {
             // Set display to not Inverted
             command(PCD8544_DISPLAYCONTROL | PCD8544_DISPLAYNORMAL);
 
-            // Clear the buffer to init it.
-            clear();
-
-            // Show a blank screen
-            update();
+            // Clear the buffer to init it and show a blank screen
+            firstPage();
+            while (nextPage());
         }
 
         void setContrast(uint8_t val) {
             if (val > 0x7f)
                 val = 0x7f;
             
-            command(PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION );
-            command(PCD8544_SETVOP | val); 
-            command(PCD8544_FUNCTIONSET);
+            bus().beginTransfer();
+            bus().command(PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION );
+            bus().command(PCD8544_SETVOP | val); 
+            bus().command(PCD8544_FUNCTIONSET);
+            bus().endTransfer();
         }
 
-        void clear() {
-            memset(buffer, 0, 84 * 48 / 8);
-            resetLimits(true);
-            
-            cursor_y = cursor_x = 0;
+        void invertDisplay(uint8_t i) {
+            command(PCD8544_DISPLAYCONTROL | (i ? PCD8544_DISPLAYINVERTED : PCD8544_DISPLAYNORMAL));
         }
 
-        void update() {
-            if(limits.y0 == limits.y1)
-                return;
-            
-            for(uint8_t y = limits.y0 / 8; y <= (limits.y1 - 1) / 8; y++) {
-                command(PCD8544_SETYADDR | y);
-
-                command(PCD8544_SETXADDR | limits.x0);
-
-                digitalWrite(dc, HIGH);
-
-                // Activate chip
-                digitalWrite(cs, LOW);
-
-                for(uint8_t x = limits.x0; x < limits.x1; x++)
-                    SPI.transfer(buffer[(width() * y) + x]);
-                    //SPI.transfer(0xFF);
-                
-                // Disable chip
-                digitalWrite(cs, HIGH);
+        LightLCDBus &bus() { return other_bus ? *other_bus : spi; }
 
-            }
-
-            command(PCD8544_SETYADDR);  // no idea why this is necessary but it is to finish the last byte?
+    protected:
+        // Default bus, and the one given instead if any
+        LightSPIBus  spi;
+        LightLCDBus *other_bus;
 
-            resetLimits(false);
+        // Keep the chip selected for the whole frame
+        void beginTransfer() {
+            bus().beginTransfer();
         }
 
-        void drawPixel(uint8_t x, uint8_t y, uint8_t color) {
-            if ((x < 0) || (x >= width()) || (y < 0) || (y >= height()))
-                return;
-
-            //bitWrite(buffer[x + (y / 8) * width()], y % 8, color);
-            if (color) 
-                buffer[x + (y / 8)*width()] |= _BV(y%8);
-            else
-                buffer[x + (y / 8)*width()] &= ~_BV(y%8);
+        void endTransfer() {
+            bus().command(PCD8544_SETYADDR);  // no idea why this is necessary but it is to finish the last byte?
 
-            expandLimits(x, y);
-        }
-
-        void invertDisplay(uint8_t i) {
-            command(PCD8544_DISPLAYCONTROL | (i ? PCD8544_DISPLAYINVERTED : PCD8544_DISPLAYNORMAL));
+            bus().endTransfer();
         }
 
-        int width()  { return 84; }
-        int height() { return 48; }
-
-    protected:
-        uint8_t dc, cs;
+        // Must be called between beginTransfer() and endTransfer()
+        void sendPage(uint8_t page, uint8_t x0, uint8_t x1) {
+            bus().command(PCD8544_SETYADDR | page);
+            bus().command(PCD8544_SETXADDR | x0);
 
-        uint8_t buffer[84 * 48 / 8];
+            bus().data(pageBuffer(page) + x0, x1 - x0 + 1);
+        }
 
         void command(uint8_t c) {
-            // Signal DATA mode
-            digitalWrite(dc, LOW);
-            // Enable chip
-            digitalWrite(cs, LOW);
-
-            SPI.transfer(c);
-
-            // Disable chip
-            digitalWrite(cs, HIGH);
+            bus().beginTransfer();
+            bus().command(c);
+            bus().endTransfer();
         }
 };
 
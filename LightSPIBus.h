@@ -0,0 +1,251 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _LIGHT_SPI_BUS_H
+#define _LIGHT_SPI_BUS_H
+
+#include "LightLCDBus.h"
+#include <SPI.h>
+
+/* 4-wire serial controllers: chip select held low for a group of writes,
+ * D/C low for commands and high for data (PCD8544, SSD1306 in SPI mode...).
+ * Leaves the actual bits to the classes below.
+ */
+class LightDCBus : public LightLCDBus {
+    public:
+        LightDCBus(uint8_t dc, uint8_t cs) : dc(dc), cs(cs) {}
+
+        void begin() {
+            pinMode(dc, OUTPUT);
+            pinMode(cs, OUTPUT);
+
+#ifdef __AVR__
+            dc_port = portOutputRegister(digitalPinToPort(dc));
+            dc_mask = digitalPinToBitMask(dc);
+            cs_port = portOutputRegister(digitalPinToPort(cs));
+            cs_mask = digitalPinToBitMask(cs);
+#endif
+
+            setCS(HIGH);
+        }
+
+    protected:
+        uint8_t dc, cs;
+
+#ifdef __AVR__
+        volatile uint8_t *dc_port, *cs_port;
+        uint8_t dc_mask, cs_mask;
+
+        void setDC(uint8_t level) { if (level) *dc_port |= dc_mask; else *dc_port &= ~dc_mask; }
+        void setCS(uint8_t level) { if (level) *cs_port |= cs_mask; else *cs_port &= ~cs_mask; }
+#else
+        void setDC(uint8_t level) { digitalWrite(dc, level); }
+        void setCS(uint8_t level) { digitalWrite(cs, level); }
+#endif
+};
+
+// Hardware SPI
+class LightSPIBus : public LightDCBus {
+    public:
+        LightSPIBus(uint8_t dc, uint8_t cs, SPISettings settings = SPISettings(4000000, MSBFIRST, SPI_MODE0), SPIClass &spi = SPI)
+            : LightDCBus(dc, cs), spi(spi), spi_settings(settings) {}
+
+        void begin() {
+            LightDCBus::begin();
+            spi.begin();
+        }
+
+        void beginTransfer() {
+            spi.beginTransaction(spi_settings);
+            setCS(LOW);
+
+            LIGHTBUS_STAT(transactions++);
+        }
+
+        void endTransfer() {
+            setCS(HIGH);
+            spi.endTransaction();
+        }
+
+        void command(uint8_t cmd) {
+            setDC(LOW);
+            spi.transfer(cmd);
+
+            LIGHTBUS_STAT(busBytes++);
+        }
+
+        void data(const uint8_t *data, uint8_t len) {
+            // The AVR loop below sends one byte before counting
+            if (len == 0)
+                return;
+
+            setDC(HIGH);
+
+            LIGHTBUS_STAT(busBytes += len);
+
+#if defined(ESP32) || defined(ESP8266)
+            spi.writeBytes(data, len);
+#elif defined(__AVR__)
+            // Load the next byte while the previous one is shifted out.
+            // SPI.transfer(buf, n) would overwrite the framebuffer.
+            SPDR = *data++;
+
+            while (--len) {
+                uint8_t b = *data++;
+                while (!(SPSR & _BV(SPIF)));
+                SPDR = b;
+            }
+
+            while (!(SPSR & _BV(SPIF)));
+#else
+            while (len--)
+                spi.transfer(*data++);
+#endif
+        }
+
+    protected:
+        SPIClass   &spi;
+        SPISettings spi_settings;
+};
+
+/* Bit-banged SPI on any two pins, mode 0, MSB first. Slower than the
+ * hardware, for boards where the SPI pins are taken.
+ */
+class LightSoftSPIBus : public LightDCBus {
+    public:
+        LightSoftSPIBus(uint8_t sclk, uint8_t mosi, uint8_t dc, uint8_t cs)
+            : LightDCBus(dc, cs), sclk(sclk), mosi(mosi) {}
+
+        void begin() {
+            LightDCBus::begin();
+
+            pinMode(sclk, OUTPUT);
+            pinMode(mosi, OUTPUT);
+
+#ifdef __AVR__
+            sclk_port = portOutputRegister(digitalPinToPort(sclk));
+            sclk_mask = digitalPinToBitMask(sclk);
+            mosi_port = portOutputRegister(digitalPinToPort(mosi));
+            mosi_mask = digitalPinToBitMask(mosi);
+#endif
+
+            setSCLK(LOW);
+        }
+
+        void beginTransfer() {
+            setCS(LOW);
+
+            LIGHTBUS_STAT(transactions++);
+        }
+
+        void endTransfer() {
+            setCS(HIGH);
+        }
+
+        void command(uint8_t cmd) {
+            setDC(LOW);
+            write(cmd);
+
+            LIGHTBUS_STAT(busBytes++);
+        }
+
+        void data(const uint8_t *data, uint8_t len) {
+            setDC(HIGH);
+
+            LIGHTBUS_STAT(busBytes += len);
+
+            while (len--)
+                write(*data++);
+        }
+
+    protected:
+        uint8_t sclk, mosi;
+
+#ifdef __AVR__
+        volatile uint8_t *sclk_port, *mosi_port;
+        uint8_t sclk_mask, mosi_mask;
+
+        void setSCLK(uint8_t level) { if (level) *sclk_port |= sclk_mask; else *sclk_port &= ~sclk_mask; }
+        void setMOSI(uint8_t level) { if (level) *mosi_port |= mosi_mask; else *mosi_port &= ~mosi_mask; }
+#else
+        void setSCLK(uint8_t level) { digitalWrite(sclk, level); }
+        void setMOSI(uint8_t level) { digitalWrite(mosi, level); }
+#endif
+
+        void write(uint8_t b) {
+            for (uint8_t bit = 0x80; bit; bit >>= 1) {
+                setMOSI(b & bit);
+                setSCLK(HIGH);
+                setSCLK(LOW);
+            }
+        }
+};
+
+/* Hardware SPI with the page data sent by DMA where the core can: data()
+ * returns once the transfer is started, and the next write waits for it.
+ * The page's bytes must not change until then, which holds while update()
+ * runs; endTransfer() waits too.
+ *
+ * Supported: RP2040 (arduino-pico, SPI.transferAsync()), or any core with
+ * the same calls if LIGHTLCD_SPI_DMA is defined. Elsewhere it's a plain
+ * LightSPIBus.
+ */
+#if defined(ARDUINO_ARCH_RP2040) && !defined(ARDUINO_ARCH_MBED) && !defined(LIGHTLCD_SPI_DMA)
+    #define LIGHTLCD_SPI_DMA
+#endif
+
+class LightDMASPIBus : public LightSPIBus {
+    public:
+        LightDMASPIBus(uint8_t dc, uint8_t cs, SPISettings settings = SPISettings(4000000, MSBFIRST, SPI_MODE0), SPIClass &spi = SPI)
+            : LightSPIBus(dc, cs, settings, spi), busy(false) {}
+
+#ifdef LIGHTLCD_SPI_DMA
+        void endTransfer() {
+            wait();
+            LightSPIBus::endTransfer();
+        }
+
+        void command(uint8_t cmd) {
+            wait();
+            LightSPIBus::command(cmd);
+        }
+
+        void data(const uint8_t *data, uint8_t len) {
+            if (len == 0)
+                return;
+
+            wait();
+            setDC(HIGH);
+
+            // Not started (another transfer running...), send it here
+            if (!spi.transferAsync(data, NULL, len)) {
+                LightSPIBus::data(data, len);
+                return;
+            }
+
+            busy = true;
+
+            LIGHTBUS_STAT(busBytes += len);
+        }
+#endif
+
+    protected:
+        uint8_t busy;
+
+        void wait() {
+#ifdef LIGHTLCD_SPI_DMA
+            if (busy)
+                while (!spi.finishedAsync());
+#endif
+            busy = false;
+        }
+};
+
+#endif
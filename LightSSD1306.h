@@ -11,8 +11,8 @@
 #ifndef _LIGHT_SSD1306_H
 #define _LIGHT_SSD1306_H
 
-#include "LightLCD.h"
-#include <Wire.h>
+#include "LightLCDBase.h"
+#include "LightI2CBus.h"
 
 #define SSD1306
  
@@ -50,32 +50,65 @@
 
 #define SSD1306_CHARGEPUMP 0x8D
 
+#define SSD1306_RIGHT_HORIZONTAL_SCROLL 0x26
+#define SSD1306_LEFT_HORIZONTAL_SCROLL 0x27
+#define SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29
+#define SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL 0x2A
+#define SSD1306_DEACTIVATE_SCROLL 0x2E
+#define SSD1306_ACTIVATE_SCROLL 0x2F
+#define SSD1306_SET_VERTICAL_SCROLL_AREA 0xA3
+
 #define SSD1306_EXTERNALVCC 0x1
 #define SSD1306_SWITCHCAPVCC 0x2
 
 #define SSD1306_LOWCONTRAST      0x00
 #define SSD1306_FULLCONTRAST     0xCF
 
-class LightSSD1306 : public LightLCD {
+/* Driver for W x H panels (128x64, 128x32), the page layout is the same
+ * for all of them.
+ *
+ * On I2C at address (0x3C or 0x3D) by default, or on any LightLCDBus:
+ *
+ *  LightSSD1306 left(0x3C), right(0x3D);
+ *
+ *  LightSPIBus spi(DC_PIN, CS_PIN, SPISettings(8000000, MSBFIRST, SPI_MODE0));
+ *  LightSSD1306 lcd(spi);
+ *
+ * The I2C bus is a member, unused when another bus is given: it costs
+ * about 10 bytes of RAM on AVR either way.
+ */
+template <uint8_t W, uint8_t H>
+class LightSSD1306Panel : public LightLCDBase<LightSSD1306Panel<W, H>, W, H> {
     public:
-        LightSSD1306() {}
+        LightSSD1306Panel(uint8_t address = 0x3C, uint32_t clock = 400000)
+            : i2c(address, clock), other_bus(NULL) {
+            init();
+        }
+
+        LightSSD1306Panel(LightLCDBus &bus) : other_bus(&bus) {
+            init();
+        }
 
         void begin() {
-            Wire.begin();
+            start_page = 0;
+            pan_line   = 0;
+            scrolling  = false;
 
-            Wire.setClock(400000);
+            LIGHTLCD_STAT(bus().stats = &this->stats);
+
+            bus().begin();
 
             byte command_sequence[] = {
                 SSD1306_DISPLAYOFF,
                 SSD1306_SETDISPLAYCLOCKDIV, 0x80,
-                SSD1306_SETMULTIPLEX,       0x3F,
+                SSD1306_SETMULTIPLEX,       H - 1,
                 SSD1306_SETDISPLAYOFFSET,   0x00, // No offset
                 SSD1306_SETSTARTLINE | 0x0, 
                 SSD1306_CHARGEPUMP,         0x14, // Force using internal high voltage
                 SSD1306_MEMORYMODE,         0x00, // Horizontal Addressing Mode (same as PCD8544)
                 SSD1306_SEGREMAP | 0x1,
                 SSD1306_COMSCANDEC,                    
-                SSD1306_SETCOMPINS,         0x12,
+                SSD1306_SETCOMPINS,         H == 32 ? 0x02 : 0x12,
                 SSD1306_SETCONTRAST,        SSD1306_FULLCONTRAST,
                 SSD1306_SETPRECHARGE,       0xF1,
                 SSD1306_SETVCOMDETECT,      0x40,
@@ -86,8 +119,11 @@ class LightSSD1306 : public LightLCD {
 
             commandList(command_sequence, 25);
 
-            clear();
-            update();
+            command(SSD1306_DEACTIVATE_SCROLL);
+
+            // Clear the buffer to init it and show a blank screen
+            this->firstPage();
+            while (this->nextPage());
         }
 
         /* Sets the the display "contrast" into three modes:
@@ -105,96 +141,303 @@ class LightSSD1306 : public LightLCD {
                     break;
                 case 1:
                     // resume and go to low contrast
-                    command(SSD1306_DISPLAYON);
-                    command(SSD1306_SETCONTRAST);
-                    command(SSD1306_LOWCONTRAST);
+                    queueCommand(SSD1306_DISPLAYON);
+                    queueCommand(SSD1306_SETCONTRAST);
+                    queueCommand(SSD1306_LOWCONTRAST);
                     break;
                 default:
                     // resume and go to full contrast
-                    command(SSD1306_DISPLAYON);
-                    command(SSD1306_SETCONTRAST);
-                    command(SSD1306_FULLCONTRAST);
+                    queueCommand(SSD1306_DISPLAYON);
+                    queueCommand(SSD1306_SETCONTRAST);
+                    queueCommand(SSD1306_FULLCONTRAST);
             }
+
+            flushCommands();
         }
 
-        void clear() {
-            memset(buffer, 0, width() * height() / 8);
-            resetLimits(true);
-            
-            cursor_y = cursor_x = 0;
+        void invertDisplay(bool invert) {
+            command(invert ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY);
         }
 
-        void update() {
-            if(limits.y0 == limits.y1)
+        /* Let scrollUp() (and console text, see setTextScroll()) move the
+         * panel's start line instead of sending the whole screen again: only
+         * the new rows go on the bus. Only whole pages (text sizes 1, 2, 3...) are
+         * scrolled this way.
+         */
+        void setStartLineScroll(uint8_t enable) {
+            startline_scroll = enable;
+
+            if (enable || start_page == 0)
                 return;
-    
-            byte command_list[] = {
-                SSD1306_COLUMNADDR,
-                    limits.x0,  // Which column to start from
-                    limits.x1,  // To which
-                SSD1306_PAGEADDR,
-                    (byte)(limits.y0 / 8),
-                    (byte)(limits.y1 / 8)
-            };
 
-            commandList(command_list, 6);
+            // Back to the plain mapping, everything has to be sent again
+            start_page = 0;
+            startline_pending = true;
+            this->invalidatePages(0, H / 8 - 1);
+        }
+
+        /* Pan the picture up by line rows, wrapping around: the framebuffer
+         * is not touched and nothing is sent but the command, so a vertical
+         * ticker only has to draw the rows coming into view.
+         */
+        void setStartLine(uint8_t line) {
+            pan_line = line % H;
+            command(SSD1306_SETSTARTLINE | startLine());
+        }
 
-            byte i = 0;
+        uint8_t getStartLine() { return pan_line; }
 
-            for(byte y = limits.y0 / 8; y <= limits.y1 / 8; y++) {   
-                for(byte x = limits.x0; x <= limits.x1; x++) {
-                    if (i == 0) {
-                        Wire.endTransmission();
+        /* Moves the picture on the panel up by rows, wrapping around like
+         * setStartLine() but done on the COM outputs.
+         */
+        void setDisplayOffset(uint8_t rows) {
+            queueCommand(SSD1306_SETDISPLAYOFFSET);
+            queueCommand(rows % H);
+            flushCommands();
+        }
 
-                        Wire.beginTransmission(0x3C);
-                        Wire.write(0x40);
-                    }
+        /* Continuous scroll done by the controller, of pages first..last.
+         *
+         * interval is the controller's step time code:
+         * 7 - 2 frames, 4 - 3, 5 - 4, 0 - 5, 6 - 25, 1 - 64, 2 - 128, 3 - 256
+         *
+         * While it runs the panel moves those pages by itself, so update()
+         * holds back the changes to them: they are sent by stopScroll().
+         */
+        void startScrollRight(uint8_t first, uint8_t last, uint8_t interval = 7) {
+            startScroll(SSD1306_RIGHT_HORIZONTAL_SCROLL, first, last, interval, 0xFF);
+        }
 
-                    Wire.write(buffer[(width() * y) + x]);
+        void startScrollLeft(uint8_t first, uint8_t last, uint8_t interval = 7) {
+            startScroll(SSD1306_LEFT_HORIZONTAL_SCROLL, first, last, interval, 0xFF);
+        }
 
-                    i = ++i % 16;
-                }
+        /* Horizontal scroll of pages first..last, plus the scroll area (see
+         * setScrollArea()) moving up by offset rows at every step.
+         */
+        void startScrollDiagRight(uint8_t first, uint8_t last, uint8_t offset, uint8_t interval = 7) {
+            startScroll(SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL, first, last, interval, offset);
+        }
+
+        void startScrollDiagLeft(uint8_t first, uint8_t last, uint8_t offset, uint8_t interval = 7) {
+            startScroll(SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL, first, last, interval, offset);
+        }
+
+        /* Rows moved by the vertical part of the diagonal scroll: the top
+         * rows stay fixed (a title bar), the next rows scroll.
+         */
+        void setScrollArea(uint8_t top, uint8_t rows) {
+            if (top >= H)
+                return;
+
+            if (rows > H - top)
+                rows = H - top;
+
+            queueCommand(SSD1306_SET_VERTICAL_SCROLL_AREA);
+            queueCommand(top);
+            queueCommand(rows);
+            flushCommands();
+        }
+
+        /* Stop the scroll: the controller leaves the scrolled pages wherever
+         * they are, they are sent again from the framebuffer by the next
+         * update().
+         */
+        void stopScroll() {
+            queueCommand(SSD1306_DEACTIVATE_SCROLL);
+
+            if (scrolling) {
+                // The vertical scroll moves the start line
+                queueCommand(SSD1306_SETSTARTLINE | startLine());
+
+                invalidateScrolled();
+                scrolling = false;
             }
 
-            Wire.endTransmission();
+            flushCommands();
+        }
+
+        uint8_t isScrolling() { return scrolling; }
+
+        /* Commands may be held back by the bus until flushCommands() (on
+         * I2C they're packed into the same transmission, after a single
+         * 0x00 control byte).
+         */
+        void queueCommand(uint8_t cmd) {
+            if (!selected) {
+                bus().beginTransfer();
+                selected = true;
+            }
 
-            resetLimits(false);
+            bus().command(cmd);
         }
 
-        void drawPixel(uint8_t x, uint8_t y, uint8_t color) {
-            if ((x < 0) || (x >= width()) || (y < 0) || (y >= height()))
+        void flushCommands() {
+            if (!selected)
                 return;
 
-            //bitWrite(buffer[x + (y / 8) * width()], y % 8, color);
-            if (color) 
-                buffer[x + (y / 8)*width()] |= _BV(y%8);
-            else
-                buffer[x + (y / 8)*width()] &= ~_BV(y%8);
+            // Within update() the bus stays selected until endTransfer()
+            if (sending) {
+                bus().flush();
+                return;
+            }
 
-            expandLimits(x, y);
+            bus().endTransfer();
+            selected = false;
         }
 
-        void invertDisplay(bool invert) {
-            command(invert ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY);
+        LightLCDBus &bus() { return other_bus ? *other_bus : i2c; }
+
+    protected:
+        // Default bus, and the one given instead if any
+        LightI2CBus  i2c;
+        LightLCDBus *other_bus;
+
+        // Between the bus' beginTransfer() and endTransfer(), and within
+        // those of LightLCD (an update)
+        uint8_t selected;
+        uint8_t sending;
+
+        // Panel RAM page shown on top, moved by scrollPanel()
+        uint8_t start_page;
+        uint8_t startline_scroll;
+        uint8_t startline_pending;
+
+        // setStartLine() pan, on top of start_page
+        uint8_t pan_line;
+
+        // Continuous scroll running on RAM pages scroll_first..scroll_last
+        uint8_t scrolling;
+        uint8_t scroll_first, scroll_last;
+
+        void init() {
+            selected = false;
+            sending  = false;
+
+            start_page = 0;
+            startline_scroll  = false;
+            startline_pending = false;
+            pan_line  = 0;
+            scrolling = false;
+        }
+
+        uint8_t startLine() {
+            return (start_page * 8 + pan_line) % H;
+        }
+
+        void startScroll(uint8_t cmd, uint8_t first, uint8_t last, uint8_t interval, uint8_t offset) {
+            if (last >= H / 8)
+                last = H / 8 - 1;
+
+            if (first > last)
+                return;
+
+            // The scroll setup can't be changed while one is running
+            stopScroll();
+
+            // Show what's in the framebuffer before it starts moving
+            this->update();
+
+            queueCommand(cmd);
+            queueCommand(0x00);
+            queueCommand(first);
+            queueCommand(interval & 0x07);
+            queueCommand(last);
+
+            if (cmd == SSD1306_RIGHT_HORIZONTAL_SCROLL || cmd == SSD1306_LEFT_HORIZONTAL_SCROLL) {
+                queueCommand(0x00);
+                queueCommand(offset);
+            } else {
+                queueCommand(offset);
+            }
+
+            queueCommand(SSD1306_ACTIVATE_SCROLL);
+            flushCommands();
+
+            scrolling    = true;
+            scroll_first = first;
+            scroll_last  = last;
+        }
+
+        // Mark the framebuffer pages living in the scrolled RAM pages
+        void invalidateScrolled() {
+            uint8_t pages = H / 8;
+
+            for (uint8_t p = 0; p < pages; p++) {
+                uint8_t ram_page = (p + start_page) % pages;
+
+                if (ram_page >= scroll_first && ram_page <= scroll_last)
+                    this->invalidatePages(p, p);
+            }
         }
 
-        int width()  { return 128; }
-        int height() { return 64; }
+        uint8_t scrollPanel(uint8_t rows) {
+            if (!startline_scroll || scrolling)
+                return false;
 
-    private:
-        uint8_t buffer[128 * 64 / 8];
+            start_page = (start_page + rows / 8) % (H / 8);
+            startline_pending = true;
+
+            return true;
+        }
+
+        void beginTransfer() {
+            if (!selected) {
+                bus().beginTransfer();
+                selected = true;
+            }
+
+            sending = true;
+
+            // The new start line goes out with the rows that scrolled in
+            if (startline_pending) {
+                command(SSD1306_SETSTARTLINE | startLine());
+                startline_pending = false;
+            }
+        }
+
+        void endTransfer() {
+            sending = false;
+            flushCommands();
+        }
+
+        void sendPage(uint8_t page, uint8_t x0, uint8_t x1) {
+            // Where the page is in the panel RAM
+            uint8_t ram_page = (page + start_page) % (H / 8);
+
+            // Writing RAM the controller is scrolling corrupts it, this
+            // page is sent again by stopScroll()
+            if (scrolling && ram_page >= scroll_first && ram_page <= scroll_last)
+                return;
+
+            byte command_list[] = {
+                SSD1306_COLUMNADDR,
+                    x0,  // Which column to start from
+                    x1,  // To which
+                SSD1306_PAGEADDR,
+                    ram_page,
+                    ram_page
+            };
+
+            commandList(command_list, 6);
+
+            bus().data(this->pageBuffer(page) + x0, x1 - x0 + 1);
+        }
 
         void command(uint8_t cmd) {
-            Wire.beginTransmission(0x3C);
-            Wire.write(0x00);
-            Wire.write(cmd);
-            Wire.endTransmission();
+            queueCommand(cmd);
+            flushCommands();
         }
 
-        void commandList(byte* commands, int count) {
-           for (byte i = 0; i < count; i++)
-                command(commands[i]);
+        void commandList(const byte* commands, uint8_t count) {
+            for (byte i = 0; i < count; i++)
+                queueCommand(commands[i]);
+
+            flushCommands();
         }
 };
 
+typedef LightSSD1306Panel<128, 64> LightSSD1306;
+typedef LightSSD1306Panel<128, 32> LightSSD1306_128x32;
+
 #endif
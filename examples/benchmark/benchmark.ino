@@ -0,0 +1,89 @@
+/* Rendering and bus benchmark.
+ *
+ * Runs typical workloads and prints, for each of them, the time per
+ * operation, the putPixel() calls it made and the bytes sent by update().
+ * Comment out USE_SSD1306 to measure a PCD8544 on pins DC=5, CS=4.
+ */
+#define USE_SSD1306
+
+#include <Wire.h>
+#include <SPI.h>
+#include <LightLCD.h>
+#include "workloads.h"
+
+#ifdef USE_SSD1306
+    #include <LightSSD1306.h>
+    typedef LightSSD1306 Driver;
+    #define DRIVER_ARGS
+#else
+    #include <LightPCD8544.h>
+    typedef LightPCD8544 Driver;
+    #define DRIVER_ARGS 5, 4
+#endif
+
+// Counts what goes through the virtual putPixel and the bytes sent
+class CountingLCD : public Driver {
+    public:
+        CountingLCD() : Driver(DRIVER_ARGS) {}
+
+        unsigned long pixels, bytes;
+
+        void putPixel(uint8_t x, uint8_t y, uint8_t color) {
+            pixels++;
+            Driver::putPixel(x, y, color);
+        }
+
+    protected:
+        void sendPage(uint8_t page, uint8_t x0, uint8_t x1) {
+            bytes += x1 - x0 + 1;
+            Driver::sendPage(page, x0, x1);
+        }
+};
+
+CountingLCD lcd;
+
+void run(const __FlashStringHelper *name, void (*workload)(LightLCD &lcd), uint8_t repeat, bool clear) {
+    unsigned long draw = 0, send = 0;
+
+    lcd.pixels = lcd.bytes = 0;
+
+    for (uint8_t i = 0; i < repeat; i++) {
+        if (clear)
+            lcd.clear();
+
+        unsigned long start = micros();
+        workload(lcd);
+        draw += micros() - start;
+
+        start = micros();
+        lcd.update();
+        send += micros() - start;
+    }
+
+    Serial.print(name);
+    Serial.print(F(": draw "));
+    Serial.print(draw / repeat);
+    Serial.print(F(" us, update "));
+    Serial.print(send / repeat);
+    Serial.print(F(" us, putPixel "));
+    Serial.print(lcd.pixels / repeat);
+    Serial.print(F(", bus bytes "));
+    Serial.println(lcd.bytes / repeat);
+}
+
+void setup() {
+    Serial.begin(115200);
+    lcd.begin();
+}
+
+void loop() {
+    run(F("full-screen text"), fullText,  10, true);
+    run(F("fillRect"),         fillRects, 10, true);
+    run(F("drawLine fan"),     lineFan,   10, true);
+    run(F("polyline plot"),    scopePlot, 10, true);
+    run(F("XBM sprites"),      sprites,   10, true);
+    run(F("status bar"),       statusBar, 50, false);
+
+    Serial.println();
+    delay(5000);
+}
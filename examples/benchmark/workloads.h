@@ -0,0 +1,59 @@
+/* Workloads shared by the benchmark sketch and the host benchmark in
+ * extras/host. Each one draws on any panel, sized to it.
+ */
+#ifndef _BENCHMARK_WORKLOADS_H
+#define _BENCHMARK_WORKLOADS_H
+
+#include <LightLCD.h>
+
+// 17x17px
+const static uint8_t xImage[] PROGMEM = {
+   0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x04, 0x41, 0x00, 0x08, 0x20, 0x00,
+   0x80, 0x03, 0x00, 0xe0, 0x0e, 0x00, 0x20, 0x08, 0x00, 0x30, 0x18, 0x00,
+   0x17, 0xd0, 0x01, 0x30, 0x18, 0x00, 0x20, 0x08, 0x00, 0xe0, 0x0e, 0x00,
+   0x80, 0x03, 0x00, 0x08, 0x20, 0x00, 0x04, 0x41, 0x00, 0x00, 0x01, 0x00,
+   0x00, 0x01, 0x00 };
+
+void fullText(LightLCD &lcd) {
+    lcd.setCursor(0, 0);
+
+    while (lcd.getCursorY() < lcd.height() - 8)
+        lcd.print("The quick brown fox ");
+}
+
+void fillRects(LightLCD &lcd) {
+    for (uint8_t i = 0; i < 16; i++)
+        lcd.fillRect(i * 3, i * 2, lcd.width() - i * 6, lcd.height() - i * 4, i % 2);
+}
+
+void lineFan(LightLCD &lcd) {
+    for (uint8_t x = 0; x < lcd.width(); x += 4)
+        lcd.drawLine(0, lcd.height() - 1, x, 0, BLACK);
+
+    for (uint8_t y = 0; y < lcd.height(); y += 4)
+        lcd.drawLine(0, lcd.height() - 1, lcd.width() - 1, y, BLACK);
+}
+
+// 100 segments, oscilloscope style
+void scopePlot(LightLCD &lcd) {
+    static uint8_t samples[101];
+
+    for (uint8_t i = 0; i <= 100; i++)
+        samples[i] = (i * 37 + millis()) % lcd.height();
+
+    lcd.drawPolyline(0, 1, samples, 101, BLACK);
+}
+
+void sprites(LightLCD &lcd) {
+    for (uint8_t y = 0; y + 17 <= lcd.height(); y += 9)
+        for (uint8_t x = 0; x + 17 <= lcd.width(); x += 13)
+            lcd.drawXBitmap(x, y, xImage, 17, 17, BLACK, y % 2);
+}
+
+void statusBar(LightLCD &lcd) {
+    lcd.fillRect(lcd.width() - 30, 0, 30, 8, WHITE);
+    lcd.setCursor(lcd.width() - 30, 0);
+    lcd.print(millis() % 1000);
+}
+
+#endif
@@ -0,0 +1,40 @@
+// Two 128x64 SSD1306 on the same I2C bus, side by side as one 256x64 display.
+// The second one has its address jumper set to 0x3D.
+
+#include <Wire.h>
+#include <LightLCD.h>
+#include <LightSSD1306.h>
+#include <LightCanvas.h>
+
+LightSSD1306 left  = LightSSD1306(0x3C);
+LightSSD1306 right = LightSSD1306(0x3D);
+
+LightCanvas<2> canvas;
+
+uint8_t counter = 0;
+
+void setup() {
+  canvas.addPanel(left,  0,   0);
+  canvas.addPanel(right, 128, 0);
+
+  canvas.begin();
+}
+
+void loop() {
+  canvas.clear();
+
+  // Sizes are 8 bits, but line ends go anywhere
+  canvas.drawLine(0, 14, canvas.width() - 1, 14, BLACK);
+
+  canvas.setCursor(4, 4);
+  canvas.print("One display, two panels: ");
+  canvas.print(counter);
+
+  // Crosses the seam between the panels
+  canvas.fillCircle(64 + counter % 128, 40, 16, BLACK);
+
+  canvas.update();
+
+  counter++;
+  delay(50);
+}
@@ -0,0 +1,34 @@
+// Keep only 2 of the 8 pages in RAM: 256 bytes instead of 1KB.
+// Must be defined before including the driver.
+#define LIGHTLCD_STRIP_PAGES 2
+
+#include <Wire.h>
+#include <LightLCD.h>
+#include <LightSSD1306.h>
+
+LightSSD1306 lcd = LightSSD1306();
+
+uint8_t counter = 0;
+
+// Called once per strip, must draw the same frame every time
+void drawScreen(LightLCD &lcd) {
+  lcd.drawRect(0, 0, lcd.width(), lcd.height(), BLACK);
+
+  lcd.setCursor(4, 4);
+  lcd.println("Page mode");
+  lcd.print("Counter: ");
+  lcd.print(counter);
+
+  lcd.fillRect(4, 40, counter % 120, 16, BLACK);
+}
+
+void setup() {
+  lcd.begin();
+}
+
+void loop() {
+  lcd.drawPages(drawScreen);
+
+  counter++;
+  delay(100);
+}
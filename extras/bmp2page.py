@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+bmp2page - convert PBM/XBM images to LightLCD page bitmaps
+
+Writes a PROGMEM C array in the panels' own layout, for
+LightLCD::drawPageBitmap(): for each 8-rows page, one byte per column,
+LSB on top. Black PBM pixels and set XBM bits become 1 (BLACK).
+
+  bmp2page.py logo.pbm                       > logo.h
+  bmp2page.py icon.xbm --mask icon_mask.pbm  > icon.h
+
+With --rle the image is run-length compressed for
+LightLCD::drawRLEBitmap(): a control byte with bit 7 set is followed by
+one byte repeated (c & 0x7F) + 1 times, otherwise by c + 1 literal bytes.
+
+  bmp2page.py splash.pbm --rle               > splash.h
+
+Author: Daniele Colanardi
+License: BSD, see LICENSE file
+"""
+
+import argparse
+import os
+import re
+import sys
+
+
+def read_pbm(data):
+    """Returns (width, height, rows) with rows[y][x] in {0, 1}."""
+    # Tokens of the header, skipping comments
+    tokens = []
+    pos = 0
+
+    while len(tokens) < 3:
+        m = re.compile(rb'\s*(#[^\n]*\n\s*)*(\S+)').match(data, pos)
+        if not m:
+            raise ValueError('truncated PBM header')
+        tokens.append(m.group(2))
+        pos = m.end()
+
+    magic, w, h = tokens[0], int(tokens[1]), int(tokens[2])
+
+    if magic == b'P1':
+        body = re.sub(rb'#[^\n]*', b'', data[pos:])
+        bits = [c - ord('0') for c in body if c in b'01']
+        return w, h, [bits[y * w:(y + 1) * w] for y in range(h)]
+
+    if magic == b'P4':
+        pos += 1  # single whitespace after the header
+        stride = (w + 7) // 8
+        rows = []
+        for y in range(h):
+            line = data[pos + y * stride:pos + (y + 1) * stride]
+            rows.append([(line[x // 8] >> (7 - x % 8)) & 1 for x in range(w)])
+        return w, h, rows
+
+    raise ValueError('not a PBM file (P1 or P4 expected)')
+
+
+def read_xbm(text):
+    w = int(re.search(r'_width\s+(\d+)', text).group(1))
+    h = int(re.search(r'_height\s+(\d+)', text).group(1))
+    body = text[text.index('{') + 1:text.index('}')]
+    data = [int(v, 16) for v in re.findall(r'0[xX][0-9a-fA-F]+', body)]
+
+    stride = (w + 7) // 8
+    return w, h, [[(data[y * stride + x // 8] >> (x % 8)) & 1 for x in range(w)] for y in range(h)]
+
+
+def read_image(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if path.lower().endswith('.xbm'):
+        return read_xbm(data.decode('ascii', 'replace'))
+
+    return read_pbm(data)
+
+
+def to_pages(w, h, rows):
+    out = []
+
+    for page in range((h + 7) // 8):
+        for x in range(w):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < h and rows[y][x]:
+                    byte |= 1 << bit
+            out.append(byte)
+
+    return out
+
+
+def rle(data):
+    out = []
+    i = 0
+
+    while i < len(data):
+        # Repeated byte
+        j = i
+        while j < len(data) and data[j] == data[i] and j - i < 128:
+            j += 1
+
+        if j - i >= 3:
+            out += [0x80 | (j - i - 1), data[i]]
+            i = j
+            continue
+
+        # Literal bytes, up to the next run of 3
+        start = i
+        while i < len(data) and i - start < 128:
+            if i + 2 < len(data) and data[i] == data[i + 1] == data[i + 2]:
+                break
+            i += 1
+
+        out += [i - start - 1] + data[start:i]
+
+    return out
+
+
+def c_array(name, data, comment):
+    lines = ['// %s' % comment, 'const static uint8_t %s[] PROGMEM = {' % name]
+
+    for i in range(0, len(data), 12):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 12]) + ',')
+
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert PBM/XBM images to LightLCD page bitmaps')
+    parser.add_argument('image', help='.pbm (P1/P4) or .xbm file')
+    parser.add_argument('--name', help='C identifier, defaults to the file name')
+    parser.add_argument('--mask', help='image with the pixels to draw (1) and to leave untouched (0)')
+    parser.add_argument('--invert', action='store_true', help='swap black and white')
+    parser.add_argument('--rle', action='store_true', help='compress the image for drawRLEBitmap()')
+    args = parser.parse_args()
+
+    name = args.name or re.sub(r'\W', '_', os.path.splitext(os.path.basename(args.image))[0])
+
+    w, h, rows = read_image(args.image)
+
+    if w > 255 or h > 255:
+        sys.exit('images are limited to 255x255')
+
+    if args.invert:
+        rows = [[1 - p for p in row] for row in rows]
+
+    pages = to_pages(w, h, rows)
+
+    if args.rle:
+        data = rle(pages)
+        comment = '%dx%dpx, RLE page format, %d bytes instead of %d' % (w, h, len(data), len(pages))
+    else:
+        data = pages
+        comment = '%dx%dpx, page format' % (w, h)
+
+    out = [
+        '#define %s_width %d' % (name, w),
+        '#define %s_height %d' % (name, h),
+        '',
+        c_array(name, data, comment),
+    ]
+
+    if args.mask:
+        mw, mh, mrows = read_image(args.mask)
+
+        if (mw, mh) != (w, h):
+            sys.exit('mask must be %dx%d' % (w, h))
+
+        out += ['', c_array(name + '_mask', to_pages(w, h, mrows), 'mask for ' + name)]
+
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
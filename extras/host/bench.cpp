@@ -0,0 +1,101 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+/* The benchmark sketch's workloads on the host, for both drivers: the
+ * SSD1306 over the stand-in Wire and the PCD8544 over the stand-in SPI
+ * with DC=5, CS=4. Times are the PC's, the counts are the same as on a
+ * board.
+ */
+
+#include <LightSSD1306.h>
+#include <LightPCD8544.h>
+
+#include "../../examples/benchmark/workloads.h"
+
+// Counts what goes through the virtual putPixel and the bytes sent
+template <class Driver>
+class CountingLCD : public Driver {
+    public:
+        using Driver::Driver;
+
+        unsigned long pixels, bytes;
+
+        void putPixel(uint8_t x, uint8_t y, uint8_t color) {
+            pixels++;
+            Driver::putPixel(x, y, color);
+        }
+
+    protected:
+        void sendPage(uint8_t page, uint8_t x0, uint8_t x1) {
+            bytes += x1 - x0 + 1;
+            Driver::sendPage(page, x0, x1);
+        }
+};
+
+// Small incremental updates: one character changed per frame
+void counter(LightLCD &lcd) {
+    static uint8_t n = 0;
+
+    lcd.setCursor(0, 0);
+    lcd.print((char)('0' + n++ % 10));
+}
+
+template <class L>
+void run(L &lcd, const char *name, void (*workload)(LightLCD &lcd), unsigned repeat, bool clear) {
+    unsigned long draw = 0, send = 0;
+
+    lcd.pixels = lcd.bytes = 0;
+    host.reset();
+
+    for (unsigned i = 0; i < repeat; i++) {
+        if (clear)
+            lcd.clear();
+
+        unsigned long start = micros();
+        workload(lcd);
+        draw += micros() - start;
+
+        start = micros();
+        lcd.update();
+        send += micros() - start;
+    }
+
+    printf("  %-18s draw %8.2f us  update %7.2f us  putPixel %6lu  bytes %5lu  bus %5lu B / %3lu tx  gpio %4lu\n",
+           name, (double)draw / repeat, (double)send / repeat, lcd.pixels / repeat, lcd.bytes / repeat,
+           (host.spiBytes + host.wireBytes) / repeat, (host.spiTransactions + host.wireTransmissions) / repeat,
+           host.gpioWrites / repeat);
+}
+
+template <class L>
+void runAll(L &lcd, const char *name) {
+    printf("%s (per update)\n", name);
+
+    lcd.begin();
+
+    run(lcd, "full-screen text", fullText,  200, true);
+    run(lcd, "fillRect",         fillRects, 200, true);
+    run(lcd, "drawLine fan",     lineFan,   200, true);
+    run(lcd, "polyline plot",    scopePlot, 200, true);
+    run(lcd, "XBM sprites",      sprites,   200, true);
+    run(lcd, "status bar",       statusBar, 1000, false);
+    run(lcd, "one character",    counter,   1000, false);
+
+    printf("\n");
+}
+
+int main() {
+    static CountingLCD<LightSSD1306> ssd1306;
+    static CountingLCD<LightPCD8544> pcd8544(5, 4);
+
+    runAll(ssd1306, "SSD1306 128x64, I2C");
+    runAll(pcd8544, "PCD8544 84x48, SPI");
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _HOST_CHECKS_H
+#define _HOST_CHECKS_H
+
+/* Helpers shared by the host checks: reference panels, the random
+ * drawing, the bus sinks feeding the emulators and the report.
+ */
+
+#include <LightSSD1306.h>
+#include <LightPCD8544.h>
+
+#include <unistd.h>
+
+#include "emulators.h"
+
+// Same sequence on every platform
+static uint32_t rnd_state;
+
+static void     seed(uint32_t s)  { rnd_state = s; }
+static uint16_t rnd(uint16_t n)   { rnd_state = rnd_state * 1103515245 + 12345; return (rnd_state >> 16) % n; }
+static int16_t  rnd(int16_t lo, int16_t hi) { return lo + (int16_t)rnd(hi - lo + 1); }
+
+// Framebuffer access for the checks
+template <class Driver>
+class Probe : public Driver {
+    public:
+        using Driver::Driver;
+
+        uint8_t pixel(uint8_t x, uint8_t y) {
+            return (this->framebuffer[x + y / 8 * this->width()] >> (y % 8)) & 1;
+        }
+
+        PageSpan dirtySpan(uint8_t page) { return this->dirty[page]; }
+};
+
+// Whole framebuffer, in strip builds too
+template <uint8_t W, uint8_t H>
+class FastPanel : public LightLCDBase<FastPanel<W, H>, W, H, H / 8> {
+    public:
+        void begin() {}
+
+        uint8_t pixel(uint8_t x, uint8_t y) {
+            return (this->framebuffer[x + y / 8 * W] >> (y % 8)) & 1;
+        }
+
+        void copyFrom(FastPanel &other) {
+            memcpy(this->framebuffer, other.framebuffer, sizeof(this->framebuffer));
+        }
+};
+
+// No framebuffer: everything goes through putPixel(), raster ops applied here
+class PixelPanel : public LightLCD {
+    public:
+        uint8_t bits[64][128];
+        uint8_t hits[64][128];
+
+        PixelPanel() {
+            clear();
+            resetClip();
+        }
+
+        void begin() {}
+
+        void clear() {
+            memset(bits, 0, sizeof(bits));
+            memset(hits, 0, sizeof(hits));
+            cursor_x = cursor_y = 0;
+        }
+
+        int width()  { return 128; }
+        int height() { return 64; }
+
+        void putPixel(uint8_t x, uint8_t y, uint8_t color) {
+            uint8_t &b = bits[y][x];
+            uint8_t  c = color ? 1 : 0;
+
+            hits[y][x]++;
+
+            switch (raster_op) {
+                case ROP_SET:    b |= c;  break;
+                case ROP_CLEAR:  b &= !c; break;
+                case ROP_XOR:    b ^= c;  break;
+                case ROP_INVERT: b ^= 1;  break;
+                default:         b = c;
+            }
+        }
+
+        uint8_t pixel(uint8_t x, uint8_t y) { return bits[y][x]; }
+};
+
+// A driver written for the old virtual drawPixel(), drawing on a PixelPanel
+class LegacyPanel : public LightLCDLegacy {
+    public:
+        PixelPanel &target;
+
+        LegacyPanel(PixelPanel &target) : target(target) {
+            resetClip();
+        }
+
+        void begin() {}
+        void clear() { target.clear(); }
+
+        int width()  { return 128; }
+        int height() { return 64; }
+
+        void drawPixel(uint8_t x, uint8_t y, uint8_t color) {
+            target.setRasterOp(raster_op);
+            target.putPixel(x, y, color);
+        }
+};
+
+static const uint8_t xbm[] PROGMEM = {    // 12x10
+    0xFF, 0x0F, 0x01, 0x08, 0xFD, 0x0B, 0x05, 0x0A, 0x65, 0x0A,
+    0x65, 0x0A, 0x05, 0x0A, 0xFD, 0x0B, 0x01, 0x08, 0xFF, 0x0F
+};
+
+static const uint8_t pages[] PROGMEM = {  // 8x16
+    0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF,
+    0x18, 0x3C, 0x7E, 0xFF, 0xFF, 0x7E, 0x3C, 0x18
+};
+
+static const uint8_t mask[] PROGMEM = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x3C, 0x7E, 0xFF, 0xFF, 0xFF, 0xFF, 0x7E, 0x3C
+};
+
+static const uint8_t rle[] PROGMEM = {    // pages[] compressed
+    0x00, 0xFF, 0x80, 0x81, 0x00, 0xBD, 0x81, 0xA5, 0x00, 0xBD, 0x80, 0x81,
+    0x03, 0xFF, 0x18, 0x3C, 0x7E, 0x81, 0xFF, 0x02, 0x7E, 0x3C, 0x18
+};
+
+// The same random drawing on any panel, within w x h
+template <class L>
+void randomDrawing(L &lcd, uint32_t s, uint16_t count, int16_t w, int16_t h) {
+    seed(s);
+
+    for (uint16_t i = 0; i < count; i++) {
+        int16_t x0 = rnd(-20, w + 20), y0 = rnd(-20, h + 20);
+        int16_t x1 = rnd(-20, w + 20), y1 = rnd(-20, h + 20);
+        int16_t x2 = rnd(0, w - 1),    y2 = rnd(0, h - 1);
+        uint8_t sw = rnd(60), sh = rnd(40), r = rnd(20);
+        uint8_t color = rnd(2);
+
+        switch (rnd(30)) {
+            case 0: lcd.resetClip(); lcd.setClipRect(rnd(w), rnd(h), rnd(w), rnd(h)); break;
+            case 1: lcd.setOrigin(rnd(-20, 20), rnd(-20, 20)); break;
+            case 2: lcd.resetClip(); break;
+            case 3: case 4: lcd.setRasterOp(rnd(5)); break;
+        }
+
+        switch (rnd(20)) {
+            case 0:  lcd.drawPixel(x0, y0, color); break;
+            case 1:  lcd.drawLine(x0, y0, x1, y1, color); break;
+            case 2:  lcd.drawRect(x0, y0, sw, sh, color); break;
+            case 3:  lcd.fillRect(x0, y0, sw, sh, color); break;
+            case 4:  lcd.drawHLine(x0, y0, sw, color); break;
+            case 5:  lcd.drawVLine(x0, y0, sh, color); break;
+            case 6:  lcd.drawChar(x0, y0, 'A' + rnd(26), color, rnd(2), 1 + rnd(5)); break;
+            case 7:  lcd.drawXBitmap(x0, y0, xbm, 12, 10, color, rnd(2)); break;
+            case 8:  lcd.drawPageBitmap(x0, y0, pages, 8, 16, color, rnd(2)); break;
+            case 9:  lcd.drawPageBitmap(x0, y0, pages, mask, 8, 16); break;
+            case 10: lcd.drawRLEBitmap(x0, y0, rle, 8, 16, color, rnd(2)); break;
+            case 11: lcd.drawCircle(x0, y0, r, color); break;
+            case 12: lcd.fillCircle(x0, y0, r, color); break;
+            case 13: lcd.drawRoundRect(x0, y0, sw, sh, r % 8, color); break;
+            case 14: lcd.fillRoundRect(x0, y0, sw, sh, r % 8, color); break;
+            case 15: lcd.drawTriangle(x0, y0, x1, y1, x2, y2, color); break;
+            case 16: lcd.fillTriangle(x0, y0, x1, y1, x2, y2, color); break;
+
+            case 17: {
+                int16_t points[] = { x0, y0, x1, y1, x2, y2, x0, y2 };
+                lcd.drawPolyline(points, 4, color);
+                break;
+            }
+
+            case 18: {
+                uint8_t ys[12];
+
+                for (uint8_t k = 0; k < 12; k++)
+                    ys[k] = rnd(h);
+
+                lcd.drawPolyline(x0, 1 + rnd(8), ys, 12, color);
+                break;
+            }
+
+            case 19:
+                lcd.setCursor(rnd(w), rnd(h));
+                lcd.print("Text 123");
+                break;
+        }
+    }
+
+    lcd.resetClip();
+    lcd.setRasterOp(ROP_COPY);
+}
+
+template <class A, class B>
+unsigned long countDiffs(A &a, B &b, uint8_t w, uint8_t h) {
+    unsigned long n = 0;
+
+    for (uint8_t y = 0; y < h; y++)
+        for (uint8_t x = 0; x < w; x++)
+            n += a.pixel(x, y) != b.pixel(x, y);
+
+    return n;
+}
+
+static int failures = 0;
+
+static void report(const char *name, unsigned long bad) {
+    printf("%-40s %s", name, bad ? "FAILED" : "ok");
+
+    if (bad)
+        printf(" (%lu)", bad);
+
+    printf("\n");
+    fflush(stdout);
+
+    if (bad)
+        failures++;
+}
+
+// Bus traffic seen by the stubs, fed to the emulators
+static SSD1306Emu *wire_emu;
+static PCD8544Emu *spi_emu;
+static uint8_t     spi_dc;
+
+static void wireSink(uint8_t, const uint8_t *data, uint8_t len) {
+    for (uint8_t i = 1; i < len; i++) {
+        if (data[0] == 0x40)
+            wire_emu->data(data[i]);
+        else
+            wire_emu->command(data[i]);
+    }
+}
+
+static void spiSink(uint8_t b) {
+    if (host.pins[spi_dc])
+        spi_emu->data(b);
+    else
+        spi_emu->command(b);
+}
+
+#endif
@@ -0,0 +1,213 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _HOST_EMULATORS_H
+#define _HOST_EMULATORS_H
+
+#include <LightLCDBus.h>
+
+/* Display RAM of the controllers, fed with the commands and data a driver
+ * sends, to check it against the framebuffer. Only what the drivers use
+ * for drawing is emulated: addressing windows, the start line and display
+ * offset, and the SSD1306's own scrolling.
+ */
+
+// 128x64 SSD1306, horizontal addressing
+struct SSD1306Emu {
+    uint8_t ram[8][128];
+    uint8_t col0, col1, page0, page1;
+    uint8_t col, page;
+    uint8_t start, offset;
+
+    // Continuous scroll set up, running if scrolling is set. Data written
+    // to the pages it moves is counted in corrupted.
+    uint8_t scroll_cmd, scroll_first, scroll_last, scroll_rows;
+    uint8_t scrolling;
+    unsigned long corrupted;
+
+    // Command waiting for its parameters
+    uint8_t pending[8];
+    uint8_t count, needed;
+
+    SSD1306Emu() {
+        memset(ram, 0x55, sizeof(ram));
+
+        col0 = page0 = col = page = start = offset = 0;
+        col1  = 127;
+        page1 = 7;
+        count = needed = 0;
+
+        scroll_cmd = scroll_first = scroll_last = scroll_rows = 0;
+        scrolling = false;
+        corrupted = 0;
+    }
+
+    static uint8_t parameters(uint8_t cmd) {
+        switch (cmd) {
+            case 0x21: case 0x22: case 0xA3:
+                return 2;
+            case 0x26: case 0x27:
+                return 6;
+            case 0x29: case 0x2A:
+                return 5;
+            case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+            case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    void command(uint8_t c) {
+        if (needed) {
+            pending[count++] = c;
+
+            if (--needed == 0)
+                run();
+
+            return;
+        }
+
+        pending[0] = c;
+        count  = 1;
+        needed = parameters(c);
+
+        if (needed == 0)
+            run();
+    }
+
+    void run() {
+        uint8_t c = pending[0];
+
+        if (c == 0x21) {
+            col0 = col  = pending[1];
+            col1 = pending[2];
+        } else if (c == 0x22) {
+            page0 = page = pending[1];
+            page1 = pending[2];
+        } else if (c >= 0x40 && c <= 0x7F) {
+            start = c - 0x40;
+        } else if (c == 0xD3) {
+            offset = pending[1];
+        } else if (c >= 0x26 && c <= 0x2A) {
+            scroll_cmd   = c;
+            scroll_first = pending[2];
+            scroll_last  = pending[4];
+            scroll_rows  = c >= 0x29 ? pending[5] : 0;
+        } else if (c == 0x2E) {
+            scrolling = false;
+        } else if (c == 0x2F) {
+            scrolling = true;
+        }
+    }
+
+    // One step of the continuous scroll: a column sideways, and scroll_rows
+    // up for the diagonal ones
+    void step() {
+        if (!scrolling)
+            return;
+
+        bool right = scroll_cmd == 0x26 || scroll_cmd == 0x29;
+
+        for (uint8_t p = scroll_first; p <= scroll_last && p < 8; p++) {
+            uint8_t *r = ram[p];
+
+            if (right) {
+                uint8_t last = r[127];
+                memmove(r + 1, r, 127);
+                r[0] = last;
+            } else {
+                uint8_t first = r[0];
+                memmove(r, r + 1, 127);
+                r[127] = first;
+            }
+        }
+
+        start = (start + scroll_rows) % 64;
+    }
+
+    void data(uint8_t d) {
+        if (scrolling && page >= scroll_first && page <= scroll_last)
+            corrupted++;
+
+        ram[page][col] = d;
+
+        if (++col > col1) {
+            col = col0;
+
+            if (++page > page1)
+                page = page0;
+        }
+    }
+
+    // Pixel shown at row y, column x
+    uint8_t pixel(uint8_t x, uint8_t y) {
+        uint8_t row = (y + offset + start) % 64;
+
+        return (ram[row / 8][x] >> (row % 8)) & 1;
+    }
+};
+
+// 84x48 PCD8544, horizontal addressing
+struct PCD8544Emu {
+    uint8_t ram[6][84];
+    uint8_t x, y;
+    uint8_t extended;
+
+    PCD8544Emu() {
+        memset(ram, 0x55, sizeof(ram));
+        x = y = extended = 0;
+    }
+
+    void command(uint8_t c) {
+        if ((c & 0xF8) == 0x20) {
+            extended = c & 1;
+        } else if (!extended) {
+            if (c & 0x80)
+                x = (c & 0x7F) % 84;
+            else if ((c & 0xF8) == 0x40)
+                y = (c & 0x07) % 6;
+        }
+    }
+
+    void data(uint8_t d) {
+        ram[y][x] = d;
+
+        if (++x == 84) {
+            x = 0;
+            y = (y + 1) % 6;
+        }
+    }
+
+    uint8_t pixel(uint8_t px, uint8_t py) {
+        return (ram[py / 8][px] >> (py % 8)) & 1;
+    }
+};
+
+// Play what a LightMockBus recorded, then forget it
+template <class Emu>
+void playLog(LightMockBus &bus, Emu &emu) {
+    for (uint16_t i = 0; i < bus.length; ) {
+        uint8_t entry = bus.log[i++];
+
+        if (entry == LIGHTBUS_COMMAND) {
+            emu.command(bus.log[i++]);
+        } else if (entry == LIGHTBUS_DATA) {
+            uint8_t len = bus.log[i++];
+
+            for (uint8_t k = 0; k < len; k++)
+                emu.data(bus.log[i++]);
+        }
+    }
+
+    bus.length = 0;
+}
+
+#endif
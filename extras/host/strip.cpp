@@ -0,0 +1,107 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+/* Strip mode checks, built with LIGHTLCD_STRIP_PAGES (see Makefile): frames
+ * drawn strip by strip with drawPages() must show on the panels the same as
+ * when drawn on a whole framebuffer.
+ *
+ * Prints one line per check, exits with the number of failed ones.
+ */
+
+#ifndef LIGHTLCD_STRIP_PAGES
+    #error "Build with -DLIGHTLCD_STRIP_PAGES=n"
+#endif
+
+#include "checks.h"
+
+// ############################################################################################
+
+static uint32_t frame_seed;
+static uint8_t  passes;
+
+// Called once per strip, draws the same frame every time
+static void drawFrame(LightLCD &lcd) {
+    passes++;
+
+    lcd.setOrigin(0, 0);
+    randomDrawing(lcd, frame_seed, 30, lcd.width(), lcd.height());
+}
+
+template <class Driver, class Emu, uint8_t W, uint8_t H>
+static unsigned long stripFrames(Driver &lcd, Emu &emu, uint32_t s) {
+    static FastPanel<W, H> ref;
+    unsigned long bad = 0;
+
+    for (uint32_t f = 0; f < 20; f++) {
+        frame_seed = s + f;
+        passes = 0;
+
+        // Through LightLCD&, or inlined on the driver type
+        if (f % 2) {
+            lcd.drawPages(drawFrame);
+        } else {
+            lcd.firstPage();
+
+            do {
+                passes++;
+                lcd.setOrigin(0, 0);
+                randomDrawing(lcd, frame_seed, 30, W, H);
+            } while (lcd.nextPage());
+        }
+
+        ref.clear();
+        ref.setOrigin(0, 0);
+        randomDrawing(ref, frame_seed, 30, W, H);
+
+        bad += countDiffs(ref, emu, W, H);
+        bad += passes != (H / 8 + LIGHTLCD_RAM_PAGES(H) - 1) / LIGHTLCD_RAM_PAGES(H);
+    }
+
+    return bad;
+}
+
+int main() {
+    // A hang is a failure too
+    alarm(60);
+
+    printf("%d pages in RAM\n", LIGHTLCD_STRIP_PAGES);
+
+    {
+        static SSD1306Emu emu;
+        static LightSSD1306 lcd;
+
+        wire_emu = &emu;
+        host.wireSink = wireSink;
+        host.reset();
+
+        lcd.begin();
+
+        report("SSD1306 strips over I2C", stripFrames<LightSSD1306, SSD1306Emu, 128, 64>(lcd, emu, 400) + host.wireOverflows);
+
+        host.wireSink = NULL;
+    }
+
+    {
+        static PCD8544Emu emu;
+        static LightPCD8544 lcd(5, 4);
+
+        spi_emu = &emu;
+        spi_dc  = 5;
+        host.spiSink = spiSink;
+
+        lcd.begin();
+
+        report("PCD8544 strips over SPI", stripFrames<LightPCD8544, PCD8544Emu, 84, 48>(lcd, emu, 500));
+
+        host.spiSink = NULL;
+    }
+
+    return failures;
+}
@@ -0,0 +1,43 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "Wire.h"
+
+#include <time.h>
+
+HostBus    host;
+HostSerial Serial;
+SPIClass   SPI;
+TwoWire    Wire;
+
+void HostBus::reset() {
+    gpioWrites        = 0;
+    spiBytes          = 0;
+    spiTransactions   = 0;
+    spiOverlaps       = 0;
+    wireBytes         = 0;
+    wireTransmissions = 0;
+    wireOverflows     = 0;
+    wireClockSets     = 0;
+}
+
+// Real time, so the benchmark can time things
+unsigned long micros() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec * 1000000UL + t.tv_nsec / 1000;
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
@@ -0,0 +1,128 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+/* Stand-in for the Arduino core, enough to build LightLCD on a PC. Pins
+ * and buses do nothing but record what they're given in `host`.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define PROGMEM
+#define PGM_P               const char *
+#define pgm_read_byte(p)    (*(const uint8_t *)(p))
+#define memcpy_P            memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+#define _BV(b) (1 << (b))
+
+#define HIGH   1
+#define LOW    0
+#define INPUT  0
+#define OUTPUT 1
+
+#define MSBFIRST  1
+#define SPI_MODE0 0
+
+// What the stand-ins saw, for the tests and the benchmark
+struct HostBus {
+    unsigned long gpioWrites;
+    unsigned long spiBytes;
+    unsigned long spiTransactions;
+    unsigned long spiOverlaps;       // Writes while an async one runs
+    unsigned long wireBytes;
+    unsigned long wireTransmissions;
+    unsigned long wireOverflows;     // Writes past the Wire buffer
+    unsigned long wireClockSets;
+    uint32_t      wireClock;         // Last one set
+
+    uint8_t pins[256];               // Last level written to each pin
+
+    // Called before each pin write, pins[] still has the old level
+    void (*pinSink)(uint8_t pin, uint8_t level);
+    // Called with each byte SPI shifts out
+    void (*spiSink)(uint8_t b);
+    // Called with each I2C transmission, when it ends
+    void (*wireSink)(uint8_t address, const uint8_t *data, uint8_t len);
+
+    void reset();
+};
+
+extern HostBus host;
+
+unsigned long micros();
+unsigned long millis();
+
+inline void delay(unsigned long) {}
+inline void pinMode(uint8_t, uint8_t) {}
+
+inline void digitalWrite(uint8_t pin, uint8_t level) {
+    // Anything but LOW is HIGH, as on the real cores
+    level = level != LOW;
+
+    if (host.pinSink)
+        host.pinSink(pin, level);
+
+    host.pins[pin] = level;
+    host.gpioWrites++;
+}
+
+class Print {
+    public:
+        virtual ~Print() {}
+
+        virtual size_t write(uint8_t c) = 0;
+
+        virtual size_t write(const uint8_t *buffer, size_t size) {
+            size_t n = 0;
+
+            while (size--)
+                n += write(*buffer++);
+
+            return n;
+        }
+
+        size_t print(const char *s)                { return write((const uint8_t *)s, strlen(s)); }
+        size_t print(const __FlashStringHelper *s) { return print((const char *)s); }
+        size_t print(char c)                       { return write((uint8_t)c); }
+        size_t print(int n)                        { return print((long)n); }
+        size_t print(unsigned int n)               { return print((unsigned long)n); }
+        size_t print(long n)                       { char b[24]; snprintf(b, sizeof(b), "%ld", n); return print(b); }
+        size_t print(unsigned long n)              { char b[24]; snprintf(b, sizeof(b), "%lu", n); return print(b); }
+
+        size_t println()                           { return write('\n'); }
+
+        template <class T>
+        size_t println(T v)                        { size_t n = print(v); return n + println(); }
+};
+
+// Serial goes to stdout
+class HostSerial : public Print {
+    public:
+        void   begin(unsigned long) {}
+        size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+
+        using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif
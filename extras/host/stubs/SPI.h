@@ -0,0 +1,80 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _HOST_SPI_H
+#define _HOST_SPI_H
+
+#include "Arduino.h"
+
+struct SPISettings {
+    SPISettings() {}
+    SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass {
+    public:
+        SPIClass() : async_data(NULL), async_len(0), async_polls(0), async_count(0) {}
+
+        void begin() {}
+
+        void beginTransaction(SPISettings) { host.spiTransactions++; }
+        void endTransaction() { host.spiOverlaps += async_len != 0; }
+
+        uint8_t transfer(uint8_t b) {
+            host.spiOverlaps += async_len != 0;
+            host.spiBytes++;
+
+            if (host.spiSink)
+                host.spiSink(b);
+
+            return 0;
+        }
+
+        /* Like arduino-pico's: the bytes go out while the caller goes on.
+         * Here they're shifted out when finishedAsync() first says so, with
+         * the pins as they are then. Every 4th one is refused.
+         */
+        bool transferAsync(const void *send, void *, size_t len) {
+            if (async_len || ++async_count % 4 == 0)
+                return false;
+
+            async_data  = (const uint8_t *)send;
+            async_len   = len;
+            async_polls = 2;
+
+            return true;
+        }
+
+        bool finishedAsync() {
+            if (async_len == 0)
+                return true;
+
+            if (--async_polls)
+                return false;
+
+            size_t len = async_len;
+            async_len = 0;
+
+            for (size_t i = 0; i < len; i++)
+                transfer(async_data[i]);
+
+            return true;
+        }
+
+    protected:
+        const uint8_t *async_data;
+        size_t         async_len;
+        uint8_t        async_polls;
+        unsigned long  async_count;
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,63 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+#ifndef _HOST_WIRE_H
+#define _HOST_WIRE_H
+
+#include "Arduino.h"
+
+// Same as the AVR core: what doesn't fit is dropped, and counted here
+#define BUFFER_LENGTH 32
+
+class TwoWire : public Print {
+    public:
+        void begin() {}
+        void setClock(uint32_t clock) {
+            host.wireClock = clock;
+            host.wireClockSets++;
+        }
+
+        void beginTransmission(uint8_t address) {
+            this->address = address;
+            length = 0;
+
+            host.wireTransmissions++;
+        }
+
+        uint8_t endTransmission(bool = true) {
+            if (host.wireSink)
+                host.wireSink(address, buffer, length);
+
+            return 0;
+        }
+
+        size_t write(uint8_t b) {
+            if (length == BUFFER_LENGTH) {
+                host.wireOverflows++;
+                return 0;
+            }
+
+            buffer[length++] = b;
+            host.wireBytes++;
+
+            return 1;
+        }
+
+        using Print::write;
+
+    protected:
+        uint8_t address;
+        uint8_t buffer[BUFFER_LENGTH];
+        uint8_t length;
+};
+
+extern TwoWire Wire;
+
+#endif
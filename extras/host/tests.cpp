@@ -0,0 +1,900 @@
+/*############################################################################################
+ LightLCD
+ Lightweight library for various LCD
+
+ Author: Daniele Colanardi
+ License: BSD, see LICENSE file
+
+ Inspired by Adafruit_PCD8544 library.
+############################################################################################*/
+
+/* Differential checks, run on the host (see Makefile):
+ *
+ * - the framebuffer fast paths against plain putPixel() drawing
+ * - what the panels show, emulated from the bus traffic, against the
+ *   framebuffer after update() / pollUpdate(), with and without a shadow
+ *   buffer, over LightMockBus and the real I2C and SPI buses (hardware,
+ *   bit-banged and DMA)
+ * - sprites against the same bitmaps drawn over the background
+ * - strip charts against a column by column model
+ * - shapes and the multi-panel canvas against single panels
+ *
+ * Prints one line per check, exits with the number of failed ones.
+ */
+
+#include <LightCanvas.h>
+
+#include "checks.h"
+
+// ############################################################################################
+
+static void fastPaths() {
+    unsigned long bad = 0, generic = 0, legacy = 0;
+
+    for (uint32_t s = 1; s <= 40; s++) {
+        static FastPanel<128, 64> fast, virt;
+        static PixelPanel         slow, old_target;
+        static LegacyPanel        old(old_target);
+
+        fast.clear();
+        virt.clear();
+        slow.clear();
+        old.clear();
+
+        // Inlined on the driver type, through the vtable otherwise
+        LightLCD &lcd = virt;
+        LightLCD &old_lcd = old;
+
+        randomDrawing(fast,    s, 200, 128, 64);
+        randomDrawing(lcd,     s, 200, 128, 64);
+        randomDrawing(slow,    s, 200, 128, 64);
+        randomDrawing(old_lcd, s, 200, 128, 64);
+
+        bad     += countDiffs(fast, slow, 128, 64);
+        generic += countDiffs(virt, slow, 128, 64);
+        legacy  += countDiffs(old_target, slow, 128, 64);
+    }
+
+    report("fast paths vs putPixel", bad);
+    report("fast paths through LightLCD&", generic);
+    report("old drawPixel() drivers", legacy);
+}
+
+// Every outline pixel filled, nothing filled outside the outline's columns
+static void triangles() {
+    unsigned long bad = 0;
+
+    seed(7);
+
+    for (uint16_t i = 0; i < 2000; i++) {
+        static PixelPanel fill, outline;
+        int16_t p[6];
+
+        for (uint8_t k = 0; k < 6; k++)
+            p[k] = rnd(k % 2 ? 64 : 128);
+
+        fill.clear();
+        outline.clear();
+
+        fill.fillTriangle(p[0], p[1], p[2], p[3], p[4], p[5], BLACK);
+        outline.drawTriangle(p[0], p[1], p[2], p[3], p[4], p[5], BLACK);
+
+        for (uint8_t x = 0; x < 128; x++) {
+            int16_t top = -1, bot = -1;
+
+            for (uint8_t y = 0; y < 64; y++) {
+                if (outline.hits[y][x]) {
+                    if (top < 0) top = y;
+                    bot = y;
+                }
+
+                bad += outline.hits[y][x] && !fill.hits[y][x];
+                bad += fill.hits[y][x] > 1;
+            }
+
+            for (uint8_t y = 0; y < 64; y++)
+                bad += fill.hits[y][x] && (top < 0 || y < top || y > bot);
+        }
+    }
+
+    report("fillTriangle covers drawTriangle", bad);
+}
+
+// ############################################################################################
+
+static uint8_t log_buffer[8192];
+
+// Draws frames on an SSD1306, sending them with update() or in slices with
+// drawing in between, then checks what the panel ended up showing.
+// The panel is on LightMockBus if mock is set, on I2C otherwise.
+// shadowMode: 1 sets a shadow buffer before begin(), 2 after it.
+// console: 1 prints lines instead, 2 also scrolls with the start line.
+static unsigned long ssd1306Frames(uint8_t mock, uint8_t shadowMode, uint8_t console) {
+    static uint8_t shadow[1024];
+
+    LightMockBus mock_bus(log_buffer, sizeof(log_buffer));
+    LightI2CBus  i2c_bus;
+    SSD1306Emu   emu;
+    unsigned long bad = 0;
+
+    Probe<LightSSD1306> lcd(mock ? (LightLCDBus &)mock_bus : i2c_bus);
+
+    wire_emu = &emu;
+    host.wireSink = wireSink;
+    host.reset();
+
+    if (shadowMode == 1)
+        lcd.setShadowBuffer(shadow);
+
+    lcd.begin();
+    playLog(mock_bus, emu);
+
+    if (shadowMode == 2)
+        lcd.setShadowBuffer(shadow);
+
+    if (console) {
+        lcd.setStartLineScroll(console == 2);
+        lcd.setTextScroll(true);
+    }
+
+    for (uint32_t f = 0; f < 40; f++) {
+        if (console) {
+            lcd.print("Line ");
+            lcd.println(f);
+
+            // Rows drawn right after a scroll, before they're sent
+            if (f % 5 == 0)
+                lcd.fillRect(0, 56, 128, 8, f % 2);
+        } else {
+            randomDrawing(lcd, f + 200, 10, 128, 64);
+        }
+
+        if (f % 3) {
+            lcd.update();
+        } else {
+            lcd.beginUpdate();
+
+            for (uint8_t k = 0; !lcd.pollUpdate(24); k++) {
+                playLog(mock_bus, emu);
+
+                if (!console && k % 4 == 0)
+                    randomDrawing(lcd, f * 31 + k, 2, 128, 64);
+            }
+
+            // Whatever was drawn during the slices goes out now
+            lcd.update();
+        }
+
+        playLog(mock_bus, emu);
+
+        bad += countDiffs(lcd, emu, 128, 64);
+        bad += mock_bus.overflow;
+    }
+
+    bad += host.wireOverflows;
+    host.wireSink = NULL;
+
+    return bad;
+}
+
+static unsigned long pcd8544Frames(Probe<LightPCD8544> &lcd, PCD8544Emu &emu, uint32_t s) {
+    unsigned long bad = 0;
+
+    lcd.begin();
+
+    for (uint32_t f = 0; f < 20; f++) {
+        randomDrawing(lcd, f + s, 10, 84, 48);
+
+        if (f % 2) {
+            lcd.update();
+        } else {
+            lcd.beginUpdate();
+            while (!lcd.pollUpdate(10));
+        }
+
+        bad += countDiffs(lcd, emu, 84, 48);
+    }
+
+    return bad;
+}
+
+// Bit-banged SPI read back from the pins: a bit at each rising edge of
+// SCLK, MSB first, with CS low and D/C steady for the whole byte
+struct SoftSPIDecoder {
+    PCD8544Emu *emu;
+    uint8_t sclk, mosi, dc, cs;
+    uint8_t bits, value;
+    unsigned long bad;
+};
+
+static SoftSPIDecoder soft;
+
+static void pinSink(uint8_t pin, uint8_t level) {
+    if ((pin == soft.dc || pin == soft.cs) && soft.bits)
+        soft.bad++;
+
+    if (pin != soft.sclk || !level || host.pins[pin])
+        return;
+
+    if (host.pins[soft.cs]) {
+        soft.bad++;
+        return;
+    }
+
+    soft.value = soft.value << 1 | host.pins[soft.mosi];
+
+    if (++soft.bits < 8)
+        return;
+
+    if (host.pins[soft.dc])
+        soft.emu->data(soft.value);
+    else
+        soft.emu->command(soft.value);
+
+    soft.bits = 0;
+}
+
+// SSD1306 in SPI mode, D/C on pin 5 and CS on pin 4
+static SSD1306Emu   *dma_emu;
+static unsigned long dma_bad;
+
+static void dmaSink(uint8_t b) {
+    // Deselected before the bytes were out
+    dma_bad += host.pins[4];
+
+    if (host.pins[5])
+        dma_emu->data(b);
+    else
+        dma_emu->command(b);
+}
+
+static void realBuses() {
+
+    report("SSD1306 over LightMockBus", ssd1306Frames(true, 0, 0));
+    report("SSD1306 over I2C", ssd1306Frames(false, 0, 0));
+    report("SSD1306 console", ssd1306Frames(true, 0, 1));
+    report("SSD1306 console, start line scroll", ssd1306Frames(true, 0, 2));
+    report("SSD1306 shadow set before begin()", ssd1306Frames(true, 1, 0));
+    report("SSD1306 shadow set after begin()", ssd1306Frames(true, 2, 0));
+    report("SSD1306 shadow over I2C", ssd1306Frames(false, 2, 0));
+    report("SSD1306 console with shadow", ssd1306Frames(true, 2, 2));
+
+    // Bytes drawn equal to the complement of the frame when the shadow
+    // buffer is set must still be sent
+    {
+        static uint8_t shadow[1024];
+        LightMockBus bus(log_buffer, sizeof(log_buffer));
+        Probe<LightSSD1306> lcd(bus);
+        SSD1306Emu emu;
+
+        lcd.begin();
+        lcd.setShadowBuffer(shadow);
+        lcd.fillRect(0, 0, 8, 8, BLACK);
+        lcd.update();
+        playLog(bus, emu);
+
+        report("SSD1306 first update with shadow", countDiffs(lcd, emu, 128, 64));
+    }
+
+    // Two panels at different clocks: it's set again only when switching
+    {
+        static LightSSD1306 left(0x3C, 400000), right(0x3D, 100000);
+        unsigned long clocks = 0;
+
+        left.begin();
+        right.begin();
+        host.reset();
+
+        for (uint8_t f = 0; f < 10; f++) {
+            left.fillRect(f * 8, 0, 8, 8, BLACK);
+            left.update();
+
+            clocks += host.wireClock != 400000;
+        }
+
+        clocks += host.wireClockSets != 1;
+
+        right.fillRect(0, 0, 8, 8, BLACK);
+        right.update();
+
+        clocks += host.wireClock != 100000;
+        clocks += host.wireClockSets != 2;
+
+        report("I2C clock set on panel switches only", clocks);
+    }
+
+    {
+        static PCD8544Emu emu;
+        static Probe<LightPCD8544> lcd(5, 4);
+
+        spi_emu = &emu;
+        spi_dc  = 5;
+        host.spiSink = spiSink;
+
+        report("PCD8544 over SPI", pcd8544Frames(lcd, emu, 300));
+
+        host.spiSink = NULL;
+    }
+
+    {
+        static PCD8544Emu emu;
+        static LightSoftSPIBus bus(10, 11, 12, 13);
+        static Probe<LightPCD8544> lcd(bus);
+
+        soft.emu  = &emu;
+        soft.sclk = 10;
+        soft.mosi = 11;
+        soft.dc   = 12;
+        soft.cs   = 13;
+        host.pinSink = pinSink;
+
+        unsigned long bad = pcd8544Frames(lcd, emu, 400);
+        bad += soft.bad + soft.bits;
+
+        report("PCD8544 over LightSoftSPIBus", bad);
+
+        host.pinSink = NULL;
+    }
+
+    // Pages end with data there, still going out when endTransfer() comes
+    {
+        static SSD1306Emu emu;
+        static LightDMASPIBus bus(5, 4);
+        static Probe<LightSSD1306> lcd(bus);
+        unsigned long bad = 0;
+
+        dma_emu = &emu;
+        dma_bad = 0;
+        host.spiSink = dmaSink;
+        host.reset();
+
+        lcd.begin();
+
+        for (uint32_t f = 0; f < 20; f++) {
+            randomDrawing(lcd, f + 500, 10, 128, 64);
+
+            if (f % 2) {
+                lcd.update();
+            } else {
+                lcd.beginUpdate();
+                while (!lcd.pollUpdate(100));
+            }
+
+            bad += countDiffs(lcd, emu, 128, 64);
+        }
+
+        bad += dma_bad + host.spiOverlaps;
+
+        report("SSD1306 over LightDMASPIBus", bad);
+
+        host.spiSink = NULL;
+    }
+}
+
+// Pixels the panel shows away from the framebuffer moved up by rows
+template <class L>
+unsigned long shiftedDiffs(L &lcd, SSD1306Emu &emu, uint8_t rows) {
+    unsigned long n = 0;
+
+    for (uint8_t y = 0; y < 64; y++)
+        for (uint8_t x = 0; x < 128; x++)
+            n += emu.pixel(x, y) != lcd.pixel(x, (y + rows) % 64);
+
+    return n;
+}
+
+// The start line, the display offset and the controller's own scrolling
+static void ssd1306Scroll() {
+    LightMockBus bus(log_buffer, sizeof(log_buffer));
+    Probe<LightSSD1306> lcd(bus);
+    SSD1306Emu emu;
+    unsigned long pan = 0, offset = 0, scroll = 0;
+
+    lcd.begin();
+    randomDrawing(lcd, 600, 40, 128, 64);
+    lcd.update();
+    playLog(bus, emu);
+
+    for (uint16_t n = 0; n < 200; n += 7) {
+        lcd.setStartLine(n);
+        playLog(bus, emu);
+
+        pan += lcd.getStartLine() != n % 64;
+        pan += shiftedDiffs(lcd, emu, n % 64);
+    }
+
+    lcd.setStartLine(0);
+
+    for (uint16_t n = 0; n < 200; n += 7) {
+        lcd.setDisplayOffset(n);
+        playLog(bus, emu);
+
+        offset += shiftedDiffs(lcd, emu, n % 64);
+    }
+
+    lcd.setDisplayOffset(0);
+    playLog(bus, emu);
+
+    // A 32 rows panel wraps at 32
+    {
+        uint8_t log32[64];
+        LightMockBus bus32(log32, sizeof(log32));
+        LightSSD1306_128x32 lcd32(bus32);
+        SSD1306Emu emu32;
+
+        lcd32.setDisplayOffset(40);
+        playLog(bus32, emu32);
+
+        offset += emu32.offset != 8;
+    }
+
+    for (uint8_t k = 0; k < 12; k++) {
+        seed(k + 700);
+
+        uint8_t first = rnd(8);
+        uint8_t last  = first + rnd(8 - first);
+        uint8_t diag  = k % 4 >= 2;
+
+        switch (k % 4) {
+            case 0: lcd.startScrollRight(first, last); break;
+            case 1: lcd.startScrollLeft(first, last); break;
+            case 2: lcd.startScrollDiagRight(first, last, 1 + rnd(4)); break;
+            case 3: lcd.startScrollDiagLeft(first, last, 1 + rnd(4)); break;
+        }
+
+        playLog(bus, emu);
+        scroll += !emu.scrolling || !lcd.isScrolling();
+
+        // Drawing goes on while the panel scrolls
+        for (uint8_t t = 0; t < 20; t++) {
+            emu.step();
+
+            randomDrawing(lcd, k * 20 + t + 800, 3, 128, 64);
+            lcd.update();
+            playLog(bus, emu);
+        }
+
+        // The other pages keep following the framebuffer
+        for (uint8_t y = 0; y < 64 && !diag; y++)
+            for (uint8_t x = 0; x < 128; x++)
+                if (y / 8 < first || y / 8 > last)
+                    scroll += emu.pixel(x, y) != lcd.pixel(x, y);
+
+        lcd.stopScroll();
+        lcd.update();
+        playLog(bus, emu);
+
+        scroll += emu.scrolling || lcd.isScrolling();
+        scroll += countDiffs(lcd, emu, 128, 64);
+        scroll += bus.overflow;
+    }
+
+    // Nothing written to the pages while they moved
+    scroll += emu.corrupted;
+
+    report("SSD1306 setStartLine()", pan);
+    report("SSD1306 setDisplayOffset()", offset);
+    report("SSD1306 continuous scroll, stopScroll()", scroll);
+}
+
+// ############################################################################################
+
+struct SpriteCase {
+    LightSprite sprite;
+    uint8_t     under[LIGHTSPRITE_UNDER(10, 16)];
+};
+
+// Sprites drawn as plain bitmaps over bg, bottom first
+static void composite(FastPanel<128, 64> &ref, FastPanel<128, 64> &bg, SpriteCase *cases, uint8_t count) {
+    ref.copyFrom(bg);
+
+    for (uint8_t i = 0; i < count; i++) {
+        LightSprite &s = cases[i].sprite;
+
+        if (!s.visible)
+            continue;
+
+        if (s.mask)
+            ref.drawPageBitmap(s.x, s.y, s.bitmap, s.mask, s.w, s.h);
+        else
+            ref.drawPageBitmap(s.x, s.y, s.bitmap, s.w, s.h, BLACK, false);
+    }
+}
+
+// Dirty spans within the columns of the two rectangles, page by page
+static unsigned long outsideRects(Probe<LightSSD1306> &lcd, int16_t ax, int16_t ay, int16_t bx, int16_t by, uint8_t w, uint8_t h) {
+    unsigned long bad = 0;
+
+    for (uint8_t p = 0; p < 8; p++) {
+        PageSpan span = lcd.dirtySpan(p);
+        int16_t lo = 255, hi = -1;
+
+        if (span.x0 > span.x1)
+            continue;
+
+        if (ay <= p * 8 + 7 && ay + h - 1 >= p * 8) {
+            if (ax < lo) lo = ax;
+            if (ax + w - 1 > hi) hi = ax + w - 1;
+        }
+
+        if (by <= p * 8 + 7 && by + h - 1 >= p * 8) {
+            if (bx < lo) lo = bx;
+            if (bx + w - 1 > hi) hi = bx + w - 1;
+        }
+
+        bad += span.x0 < lo || span.x1 > hi;
+    }
+
+    return bad;
+}
+
+static void sprites() {
+    static uint8_t flipped[16];
+    static SpriteCase cases[3];
+    static FastPanel<128, 64> bg, ref;
+
+    LightMockBus bus(log_buffer, sizeof(log_buffer));
+    Probe<LightSSD1306> lcd(bus);
+    SSD1306Emu emu;
+    unsigned long bad = 0, restored = 0, dirty = 0;
+
+    for (uint8_t i = 0; i < 16; i++)
+        flipped[i] = ~pgm_read_byte(pages + i);
+
+    lcd.begin();
+    bg.clear();
+
+    // Masked, opaque, and a height that isn't a whole page
+    lcd.addSprite(cases[0].sprite, pages, mask, 8,  16, cases[0].under);
+    lcd.addSprite(cases[1].sprite, pages, NULL, 8,  16, cases[1].under);
+    lcd.addSprite(cases[2].sprite, xbm,   NULL, 10, 12, cases[2].under);
+
+    seed(11);
+
+    for (uint16_t f = 0; f < 300; f++) {
+        LightSprite &s = cases[rnd(3)].sprite;
+
+        switch (rnd(8)) {
+            case 0:
+                lcd.showSprite(s, !s.visible);
+                break;
+
+            case 1:
+                // Drawing on the background
+                lcd.hideSprites();
+                restored += countDiffs(lcd, bg, 128, 64);
+
+                randomDrawing(lcd, f, 3, 128, 64);
+                randomDrawing(bg, f, 3, 128, 64);
+                break;
+
+            case 2:
+                lcd.setSpriteImage(s, s.bitmap == pages ? flipped : s.bitmap == flipped ? pages : s.bitmap, s.mask);
+                break;
+
+            default:
+                // Near each other, so they overlap often
+                lcd.moveSprite(s, rnd(-12, 50), rnd(-12, 50));
+        }
+
+        lcd.update();
+        playLog(bus, emu);
+
+        composite(ref, bg, cases, 3);
+        bad += countDiffs(emu, ref, 128, 64);
+    }
+
+    // Moving one alone dirties where it was and where it goes, nothing else
+    for (uint8_t i = 0; i < 3; i++)
+        lcd.showSprite(cases[i].sprite, i == 2);
+
+    lcd.update();
+    playLog(bus, emu);
+
+    for (uint16_t f = 0; f < 200; f++) {
+        LightSprite &s = cases[2].sprite;
+        int16_t x = s.x, y = s.y;
+
+        lcd.moveSprite(s, rnd(-12, 130), rnd(-12, 66));
+        lcd.drawSprites();
+
+        dirty += outsideRects(lcd, x, y, s.x, s.y, s.w, s.h);
+
+        lcd.update();
+        playLog(bus, emu);
+    }
+
+    composite(ref, bg, cases, 3);
+    bad += countDiffs(emu, ref, 128, 64);
+
+    // The background comes back exactly
+    for (uint8_t i = 0; i < 3; i++)
+        lcd.removeSprite(cases[i].sprite);
+
+    lcd.update();
+    playLog(bus, emu);
+
+    restored += countDiffs(lcd, bg, 128, 64);
+    restored += countDiffs(emu, bg, 128, 64);
+    bad += bus.overflow;
+
+    report("sprites vs bitmaps over the background", bad);
+    report("sprites give the background back", restored);
+    report("sprites dirty their old and new places", dirty);
+}
+
+// ############################################################################################
+
+// What a strip chart should show, one sample at a time
+struct ChartModel {
+    int16_t x, y, w, h;
+    int32_t lo, hi;
+    uint8_t per_column, filled;
+
+    uint8_t count;
+    int32_t min, max;
+    int16_t last;
+
+    int16_t top[128], bot[128];     // Empty when top > bot
+
+    ChartModel(int16_t x, int16_t y, int16_t w, int16_t h, int32_t lo, int32_t hi, uint8_t per_column, uint8_t filled)
+        : x(x), y(y), w(w), h(h), lo(lo), hi(hi), per_column(per_column), filled(filled), count(0), last(-1) {
+        for (uint8_t i = 0; i < w; i++) {
+            top[i] = 1;
+            bot[i] = 0;
+        }
+    }
+
+    int16_t row(int32_t v) {
+        if (v < lo) v = lo;
+        if (v > hi) v = hi;
+
+        return y + h - 1 - (int16_t)((v - lo) * (h - 1) / (hi - lo));
+    }
+
+    void add(int16_t v) {
+        if (count == 0 || v < min) min = v;
+        if (count == 0 || v > max) max = v;
+
+        if (++count < per_column)
+            return;
+
+        int16_t t = row(max), b = row(min);
+
+        if (last >= 0) {
+            if (last < t) t = last;
+            if (last > b) b = last;
+        }
+
+        if (filled)
+            b = y + h - 1;
+
+        last  = row(v);
+        count = 0;
+
+        memmove(top, top + 1, (w - 1) * sizeof(top[0]));
+        memmove(bot, bot + 1, (w - 1) * sizeof(bot[0]));
+        top[w - 1] = t;
+        bot[w - 1] = b;
+    }
+
+    // -1 outside the chart
+    int8_t pixel(int16_t px, int16_t py) {
+        if (px < x || px >= x + w || py < y || py >= y + h)
+            return -1;
+
+        return top[px - x] <= py && py <= bot[px - x];
+    }
+};
+
+// Samples added in batches of up to maxBatch under raster op, checked on the
+// emulated panel after every update, the background around the chart left
+// alone
+static unsigned long chartRun(ChartModel &m, int16_t lo, int16_t hi, uint8_t maxBatch, uint32_t s, uint8_t op = ROP_COPY) {
+    static FastPanel<128, 64> bg;
+    static int16_t values[255];
+
+    LightMockBus bus(log_buffer, sizeof(log_buffer));
+    Probe<LightSSD1306> lcd(bus);
+    SSD1306Emu emu;
+    LightChart chart;
+    unsigned long bad = 0;
+
+    lcd.begin();
+    bg.clear();
+
+    randomDrawing(lcd, s, 40, 128, 64);
+    randomDrawing(bg, s, 40, 128, 64);
+    lcd.setOrigin(0, 0);
+
+    lcd.setupChart(chart, m.x, m.y, m.w, m.h, lo, hi, m.per_column);
+    lcd.setRasterOp(op);
+    chart.filled = m.filled;
+
+    seed(s);
+
+    int32_t v = 0;
+
+    for (uint16_t f = 0; f < 100; f++) {
+        uint8_t count = 1 + rnd(maxBatch);
+
+        for (uint8_t i = 0; i < count; i++) {
+            // A random walk, with jumps to the ends and past them
+            switch (rnd(8)) {
+                case 0:  v = lo - rnd(100); break;
+                case 1:  v = hi + rnd(100); break;
+                default: v += rnd(-(m.h + 10), m.h + 10) * ((int32_t)hi - lo) / 64;
+            }
+
+            if (v < -32768) v = -32768;
+            if (v > 32767)  v = 32767;
+
+            values[i] = v;
+            m.add(v);
+        }
+
+        if (count == 1)
+            lcd.addChartSample(chart, values[0]);
+        else
+            lcd.addChartSamples(chart, values, count);
+
+        lcd.update();
+        playLog(bus, emu);
+
+        for (uint8_t y = 0; y < 64; y++)
+            for (uint8_t x = 0; x < 128; x++) {
+                int8_t want = m.pixel(x, y);
+                bad += emu.pixel(x, y) != (want < 0 ? bg.pixel(x, y) : want);
+            }
+    }
+
+    return bad + bus.overflow;
+}
+
+static void charts() {
+    unsigned long bad = 0;
+
+    // Off page boundaries, several samples per column
+    ChartModel ranges(10, 13, 50, 30, -100, 100, 3, false);
+    bad += chartRun(ranges, -100, 100, 20, 1);
+
+    // Batches longer than the chart is wide
+    ChartModel batches(0, 5, 40, 20, 0, 1000, 1, false);
+    bad += chartRun(batches, 0, 1000, 255, 2);
+
+    ChartModel filled(70, 0, 58, 64, -500, 500, 2, true);
+    bad += chartRun(filled, -500, 500, 10, 3);
+
+    report("charts vs model", bad);
+
+    // A range wider than int16_t
+    ChartModel wide(3, 20, 120, 37, -30000, 30000, 1, false);
+    report("charts over the whole int16_t range", chartRun(wide, -30000, 30000, 5, 4));
+
+    // The trace is BLACK whatever raster op is set
+    bad = 0;
+
+    for (uint8_t op = ROP_SET; op <= ROP_INVERT; op++) {
+        ChartModel model(10, 13, 50, 30, -100, 100, 2, op % 2);
+        bad += chartRun(model, -100, 100, 8, 5 + op, op);
+    }
+
+    report("charts under raster ops", bad);
+}
+
+// ############################################################################################
+
+static void canvas() {
+    static uint8_t log_a[64], log_b[64];
+
+    LightMockBus bus_a(log_a, sizeof(log_a)), bus_b(log_b, sizeof(log_b));
+    static Probe<LightSSD1306> top(bus_a), bottom(bus_b);
+    static FastPanel<128, 128> whole;
+    unsigned long bad = 0;
+
+    LightCanvas<2> canvas;
+    canvas.addPanel(top, 0, 0);
+    canvas.addPanel(bottom, 0, 64);
+
+    for (uint32_t s = 1; s <= 10; s++) {
+        canvas.clear();
+        whole.clear();
+
+        randomDrawing(canvas, s, 200, 128, 128);
+        randomDrawing(whole, s, 200, 128, 128);
+
+        for (uint8_t y = 0; y < 128; y++)
+            for (uint8_t x = 0; x < 128; x++)
+                bad += whole.pixel(x, y) != (y < 64 ? top.pixel(x, y) : bottom.pixel(x, y - 64));
+    }
+
+    report("canvas vs one panel", bad);
+    bad = 0;
+
+    // The panels' own settings are left alone
+    bottom.setOrigin(3, 4);
+    bottom.setRasterOp(ROP_XOR);
+    canvas.fillRect(0, 60, 20, 8, BLACK);
+
+    LightLCD &generic = canvas;
+    generic.drawPixel(5, 70, BLACK);
+
+    bottom.resetClip();
+    bottom.clear();
+    bottom.setOrigin(0, 0);
+    bottom.fillRect(0, 0, 2, 2, BLACK);
+
+    bad += bottom.getRasterOp() != ROP_XOR;
+    bad += bottom.pixel(0, 0) != 1 || bottom.pixel(1, 1) != 1;
+
+    // 256 pixels wide, through the putPixel() fallback too
+    LightCanvas<2> wide;
+    wide.addPanel(top, 0, 0);
+    wide.addPanel(bottom, 128, 0);
+    wide.clear();
+
+    LightLCD &wide_generic = wide;
+    wide_generic.fillRect(250, 0, 6, 4, BLACK);
+    wide.drawLine(0, 0, 255, 63, BLACK);
+
+    bad += bottom.pixel(127, 0) != 1 || bottom.pixel(127, 63) != 1;
+
+    // A 256 pixels run, from one edge to the other
+    wide_generic.drawLine(0, 10, 255, 10, BLACK);
+
+    for (uint8_t x = 0; x < 128; x++)
+        bad += top.pixel(x, 10) != 1 || bottom.pixel(x, 10) != 1;
+
+    report("canvas panel state, 256 wide", bad);
+}
+
+// ############################################################################################
+
+#ifdef LIGHTLCD_STATS
+static void primitives() {
+    static FastPanel<128, 64> lcd;
+    unsigned long bad = 0;
+
+    #define ONCE(call) lcd.resetStats(); lcd.call; bad += lcd.getStats().primitives != 1
+
+    ONCE(fillRect(5, 5, 60, 40, BLACK));
+    ONCE(drawRect(5, 5, 60, 40, BLACK));
+    ONCE(drawCircle(60, 30, 20, BLACK));
+    ONCE(fillCircle(60, 30, 20, BLACK));
+    ONCE(drawRoundRect(5, 5, 60, 40, 8, BLACK));
+    ONCE(fillRoundRect(5, 5, 60, 40, 8, BLACK));
+    ONCE(drawTriangle(1, 2, 100, 30, 40, 60, BLACK));
+    ONCE(fillTriangle(1, 2, 100, 30, 40, 60, BLACK));
+    ONCE(drawLine(0, 0, 100, 50, BLACK));
+    ONCE(drawChar(3, 3, 'A'));
+    ONCE(drawRLEBitmap(3, 3, rle, 8, 16, BLACK, 0));
+
+    // Clipped away entirely, still called
+    ONCE(fillRect(-70, 5, 60, 40, BLACK));
+    ONCE(drawRLEBitmap(-20, 5, rle, 8, 16, BLACK, 0));
+    ONCE(drawRLEBitmap(3, 70, rle, 8, 16, BLACK, 0));
+
+    #undef ONCE
+
+    report("one primitive per drawing call", bad);
+}
+#endif
+
+int main() {
+    // A hang is a failure too
+    alarm(120);
+
+    fastPaths();
+    triangles();
+    realBuses();
+    ssd1306Scroll();
+    sprites();
+    charts();
+    canvas();
+
+#ifdef LIGHTLCD_STATS
+    primitives();
+#endif
+
+    return failures;
+}
@@ -5,7 +5,7 @@
 
 // standard ascii 5x7 font
 
-const char PROGMEM font[] = {
+const unsigned char PROGMEM font[] = {
     0x00, 0x00, 0x00, 0x00, 0x00,   
 	0x3E, 0x5B, 0x4F, 0x5B, 0x3E, 	
 	0x3E, 0x6B, 0x4F, 0x6B, 0x3E, 	
@@ -140,7 +140,7 @@ const char PROGMEM font[] = {
     
 };
 
-const char PROGMEM font_width[] = {
+const unsigned char PROGMEM font_width[] = {
     5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 5, 5, 5, 5, 5, 5,
     5, 5, 5, 5, 5, 3, 1, 3, 5, 4, 5, 5, 1, 2, 2, 3, 3, 2, 3, 1, 5, 4, 3, 4, 4, 4, 4,
     4, 4, 4, 4, 1, 1, 3, 3, 3, 4, 5, 4, 4, 3, 4, 4, 4, 4, 4, 3, 4, 4, 3, 5, 4, 4, 4,